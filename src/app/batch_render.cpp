@@ -0,0 +1,195 @@
+#include "app/batch_render.h"
+#include "app/wav_writer.h"
+#include "dsp/worker_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace msm5232 {
+
+namespace {
+
+// Integer keys that may hold lists/ranges, with their valid range
+struct IntKey {
+    const char* name;
+    int lo, hi;
+    std::vector<int> values;
+};
+
+// "1-15", "0,64,127", "60-72,84"; every value must lie in [lo, hi] (checked before a
+// range is expanded, so a huge range cannot exhaust memory)
+bool parse_int_list(const std::string& v, int lo, int hi, std::vector<int>& out) {
+    out.clear();
+    std::stringstream ss(v);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) return false;
+        char* end = nullptr;
+        long a = std::strtol(item.c_str(), &end, 10);
+        long b = a;
+        if (*end == '-' && end != item.c_str()) b = std::strtol(end + 1, &end, 10);
+        if (*end != '\0' || b < a || a < lo || b > hi) return false;
+        for (long x = a; x <= b; ++x) out.push_back((int)x);
+    }
+    return !out.empty();
+}
+
+bool parse_float(const std::string& v, float& out) {
+    char* end = nullptr;
+    out = std::strtof(v.c_str(), &end);
+    return !v.empty() && *end == '\0';
+}
+
+std::string expand(std::string s, const char* name, int value) {
+    const std::string tag = std::string("{") + name + "}";
+    const std::string rep = std::to_string(value);
+    for (size_t p = s.find(tag); p != std::string::npos; p = s.find(tag, p + rep.size())) s.replace(p, tag.size(), rep);
+    return s;
+}
+
+bool render_job(const BatchJob& job, int sr, Isa isa, WavFormat format) {
+    Synth synth;
+    synth.setVoiceCount(1);
+    synth.setRealtime(false);
+    synth.setIsa(isa);
+    synth.setup((float)sr);
+    SynthParams p = job.params;
+    p.polyphony = 1;
+    synth.setParams(p);
+
+    const int gate = std::max(0, (int)(job.gateSeconds * (float)sr));
+    const int total = gate + std::max(0, (int)(job.tailSeconds * (float)sr));
+    WavWriter wav;
+    if (!wav.open(job.out, sr, format)) return false;
+    float L[256], R[256];
+    synth.noteOn(job.note, job.velocity);
+    for (int i = 0; i < total;) {
+        if (i == gate) synth.noteOff(job.note);
+        // Blocks end at the gate so the note-off is sample accurate
+        int end = std::min(total, i + 256);
+        if (i < gate) end = std::min(end, gate);
+        synth.process(L, R, end - i);
+        if (!wav.write(L, R, end - i)) {
+            wav.close();
+            return false;
+        }
+        i = end;
+    }
+    return wav.close();
+}
+
+}
+
+bool parse_batch_spec(const std::string& path, std::vector<BatchJob>& jobs, std::string& err) {
+    std::ifstream in(path);
+    if (!in) { err = "cannot open " + path; return false; }
+    std::set<std::string> outputs;
+    std::string line;
+    for (int lineNo = 1; std::getline(in, line); ++lineNo) {
+        const std::string where = path + ":" + std::to_string(lineNo) + ": ";
+        line = line.substr(0, line.find('#'));
+        std::stringstream ss(line);
+        std::string tok;
+        // Defaults match the single-render mode
+        IntKey keys[] = {
+            {"tone", 1, 15, {15}}, {"quant", 0, 1, {1}}, {"table", 64, 256, {128}}, {"note", 0, 127, {60}},
+            {"vel", 1, 127, {100}}, {"bl", 0, 8, {0}}, {"hq", 0, 4, {0}},
+        };
+        BatchJob proto;
+        proto.params.adsr.attack = 0.01f;
+        proto.params.adsr.decay = 0.2f;
+        proto.params.adsr.sustain = 0.6f;
+        proto.params.adsr.release = 0.3f;
+        proto.params.gain = 0.3f;
+        bool any = false;
+        while (ss >> tok) {
+            any = true;
+            const size_t eq = tok.find('=');
+            if (eq == std::string::npos) { err = where + "expected key=value, got '" + tok + "'"; return false; }
+            const std::string k = tok.substr(0, eq);
+            const std::string v = tok.substr(eq + 1);
+            bool ok = true;
+            IntKey* ik = nullptr;
+            for (auto& key : keys) if (k == key.name) ik = &key;
+            if (ik) {
+                ok = parse_int_list(v, ik->lo, ik->hi, ik->values);
+                if (ik == &keys[2]) for (int x : ik->values) ok = ok && (x == 64 || x == 128 || x == 256);
+            } else if (k == "out") {
+                proto.out = v;
+                ok = !v.empty();
+            } else if (k == "gate") {
+                ok = parse_float(v, proto.gateSeconds);
+            } else if (k == "tail") {
+                ok = parse_float(v, proto.tailSeconds);
+            } else if (k == "attack") {
+                ok = parse_float(v, proto.params.adsr.attack);
+            } else if (k == "decay") {
+                ok = parse_float(v, proto.params.adsr.decay);
+            } else if (k == "sustain") {
+                ok = parse_float(v, proto.params.adsr.sustain);
+            } else if (k == "release") {
+                ok = parse_float(v, proto.params.adsr.release);
+            } else if (k == "gain") {
+                ok = parse_float(v, proto.params.gain);
+            } else {
+                err = where + "unknown key '" + k + "'";
+                return false;
+            }
+            if (!ok) { err = where + "bad value for '" + k + "': " + v; return false; }
+        }
+        if (!any) continue;
+        if (proto.out.empty()) { err = where + "missing out="; return false; }
+
+        // Every combination of the integer keys (odometer over the value lists)
+        const int nKeys = (int)(sizeof(keys) / sizeof(keys[0]));
+        std::vector<size_t> idx((size_t)nKeys, 0);
+        for (;;) {
+            BatchJob j = proto;
+            int v[7];
+            for (int k = 0; k < nKeys; ++k) {
+                v[k] = keys[k].values[idx[(size_t)k]];
+                j.out = expand(j.out, keys[k].name, v[k]);
+            }
+            j.params.toneMask = v[0];
+            j.params.quantize4 = v[1] != 0;
+            j.params.tableLen = v[2];
+            j.note = v[3];
+            j.velocity = v[4];
+            j.params.blQuality = v[5];
+            j.params.hqMode = v[6];
+            if (!outputs.insert(j.out).second) {
+                err = where + "output '" + j.out + "' is written twice (add a placeholder to out=)";
+                return false;
+            }
+            jobs.push_back(std::move(j));
+            int k = nKeys - 1;
+            for (; k >= 0; --k) {
+                if (++idx[(size_t)k] < keys[k].values.size()) break;
+                idx[(size_t)k] = 0;
+            }
+            if (k < 0) break;
+        }
+    }
+    return true;
+}
+
+int run_batch(const std::vector<BatchJob>& jobs, int sampleRate, Isa isa, WavFormat format, int threads) {
+    // Jobs share the process-wide table cache; hold it so it outlives each job's Synth
+    std::shared_ptr<TableSetCache> cache = TableSetCache::shared();
+    std::atomic<int> failed{0};
+    auto job = [&](int j, int) {
+        if (!render_job(jobs[(size_t)j], sampleRate, isa, format)) {
+            ++failed;
+            std::fprintf(stderr, "failed to write %s\n", jobs[(size_t)j].out.c_str());
+        }
+    };
+    WorkerPool pool(std::max(1, threads));
+    pool.run((int)jobs.size(), job);
+    return failed.load();
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "dsp/synth.h"
+#include "app/wav_writer.h"
+#include <string>
+#include <vector>
+
+namespace msm5232 {
+
+// One single-note render of the batch mode: note on for gateSeconds, then tailSeconds of release
+struct BatchJob {
+    std::string out;
+    SynthParams params{};
+    int note = 60;
+    int velocity = 100;
+    float gateSeconds = 1.0f;
+    float tailSeconds = 0.5f;
+};
+
+// Read a job spec: one line per job group, '#' starts a comment. Each line holds
+// key=value pairs; integer keys (tone, quant, table, note, vel, bl, hq) take lists
+// and ranges ("1-15", "0,64,127") and the line expands to every combination.
+// out is a file pattern with {tone} {quant} {table} {note} {vel} {bl} {hq} placeholders.
+// Returns false (with err) on a syntax error or when two jobs would write the same file.
+bool parse_batch_spec(const std::string& path, std::vector<BatchJob>& jobs, std::string& err);
+
+// Render every job with its own Synth on `threads` workers (jobs are claimed
+// dynamically, so long and short jobs balance out). Returns the number of failed jobs.
+int run_batch(const std::vector<BatchJob>& jobs, int sampleRate, Isa isa, WavFormat format, int threads);
+
+}
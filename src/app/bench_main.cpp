@@ -0,0 +1,398 @@
+#include "dsp/synth.h"
+#include "dsp/bandlimited.h"
+#include "dsp/decimator.h"
+#include "dsp/dsp_kernels.h"
+#include "dsp/voice_bank.h"
+#include "dsp/fastmath.h"
+#include "dsp/msm5232_wavetable.h"
+#include "dsp/rt_check.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace msm5232;
+
+// Benchmark harness for the DSP library. Prints one JSON object per line (JSON Lines):
+// a "meta" record, then one record per case, so results can be diffed or loaded into a
+// spreadsheet across releases. Timings are wall clock on the calling thread.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Keeps results observable so the optimizer cannot drop the measured work
+volatile float g_sink = 0.0f;
+
+struct Options {
+    Isa isa = Isa::Auto;
+    int threads = 1;
+    bool full = false;
+    double minTime = 0.25; // seconds of wall time per case
+    std::string filter;    // only run cases whose name contains this
+    bool rtCheck = false;
+    bool checkFastmath = false; // accuracy checks only, no timing
+    bool failOnRegression = false; // kernels: exit non-zero on a timing regression
+};
+
+bool selected(const Options& o, const char* name) {
+    return o.filter.empty() || std::strstr(name, o.filter.c_str()) != nullptr;
+}
+
+// Call fn() until at least minTime has passed; returns seconds per call
+template <typename Fn>
+double time_per_call(double minTime, Fn fn, long& iters) {
+    fn(); // warm-up (first-touch allocations, caches)
+    iters = 0;
+    const auto t0 = Clock::now();
+    double el = 0.0;
+    do {
+        fn();
+        ++iters;
+        el = seconds_since(t0);
+    } while (el < minTime);
+    return el / (double)iters;
+}
+
+void print_micro(const char* name, const char* args, double secPerCall, long iters) {
+    std::printf("{\"bench\":\"%s\",%s\"ns_per_call\":%.1f,\"iters\":%ld}\n", name, args, secPerCall * 1e9, iters);
+}
+
+// Synth::process() throughput with poly sustained notes spread over five octaves
+void bench_process(const Options& o, const SynthParams& base, int poly, int block, int sr) {
+    Synth synth;
+    synth.setRealtime(false);
+    synth.setIsa(o.isa);
+    synth.setRenderThreads(o.threads);
+    synth.setVoiceCount(poly);
+    synth.setup((float)sr);
+    SynthParams p = base;
+    p.polyphony = poly;
+    synth.setParams(p);
+    synth.setVibratoDepthSemis(0.2f); // keeps Auto2x deciding per sub-block
+    for (int v = 0; v < poly; ++v) synth.noteOn(36 + (v * 7) % 60, 100);
+
+    std::vector<float> L((size_t)block), R((size_t)block);
+    // Past the attack, so every case measures the steady state
+    for (int i = 0; i < sr / 10; i += block) synth.process(L.data(), R.data(), block);
+    long frames = 0;
+    const auto t0 = Clock::now();
+    double el = 0.0;
+    do {
+        for (int k = 0; k < 16; ++k) synth.process(L.data(), R.data(), block);
+        frames += 16L * block;
+        el = seconds_since(t0);
+    } while (el < o.minTime);
+    g_sink = g_sink + L[0];
+
+    const double rt = ((double)frames / (double)sr) / el;
+    std::printf("{\"bench\":\"process\",\"bl\":%d,\"hq\":%d,\"path\":%d,\"table\":%d,\"quant\":%d,"
+                "\"poly\":%d,\"block\":%d,\"realtime_factor\":%.2f,\"voices_x_rt\":%.1f,"
+                "\"ns_per_voice_sample\":%.2f}\n",
+                p.blQuality, p.hqMode, p.hqPath, p.tableLen, p.quantize4 ? 1 : 0, poly, block, rt, rt * poly,
+                el * 1e9 / ((double)frames * poly));
+    std::fflush(stdout);
+}
+
+void run_process_grid(const Options& o, int sr) {
+    // Default grid: the common settings; --full: every combination
+    const std::vector<int> bls = o.full ? std::vector<int>{0, 1, 2, 4, 8} : std::vector<int>{0, 4};
+    const std::vector<int> hqs = o.full ? std::vector<int>{0, 1, 2, 3, 4} : std::vector<int>{0, 2, 4};
+    const std::vector<int> paths = o.full ? std::vector<int>{0, 1} : std::vector<int>{0};
+    const std::vector<int> tables = o.full ? std::vector<int>{64, 128} : std::vector<int>{128};
+    const std::vector<int> quants = o.full ? std::vector<int>{0, 1} : std::vector<int>{1};
+    const std::vector<int> polys = o.full ? std::vector<int>{1, 8, 32, 128} : std::vector<int>{1, 32, 128};
+    const std::vector<int> blocks = o.full ? std::vector<int>{32, 128, 512} : std::vector<int>{64, 512};
+    SynthParams p;
+    p.toneMask = 15;
+    p.gain = 0.1f;
+    p.adsr.attack = 0.001f;
+    p.adsr.decay = 0.05f;
+    p.adsr.sustain = 1.0f;
+    p.adsr.release = 0.3f;
+    for (int bl : bls) for (int hq : hqs) for (int path : paths) for (int table : tables)
+    for (int quant : quants) for (int poly : polys) for (int block : blocks) {
+        // The HQ path only matters when oversampling is on
+        if (hq == 0 && path != 0) continue;
+        p.blQuality = bl;
+        p.hqMode = hq;
+        p.hqPath = path;
+        p.tableLen = table;
+        p.quantize4 = quant != 0;
+        bench_process(o, p, poly, block, sr);
+    }
+}
+
+// Best of several shorter timings: robust against a burst of noise during one of them
+template <typename Fn>
+double best_time_per_call(double minTime, Fn fn) {
+    long iters = 0;
+    double best = 1e30;
+    for (int r = 0; r < 5; ++r) best = std::min(best, time_per_call(minTime / 5.0, fn, iters));
+    return best;
+}
+
+// Every DspKernels entry for each ISA this CPU runs. A wider kernel set should not be
+// slower than SSE2 for an entry it replaces (entries shared with SSE2 are skipped): rows
+// more than 10% slower are flagged. Timing is noisy, so this only fails (returns false)
+// with --fail-on-regression.
+bool run_kernels(const Options& o, const Table& base) {
+    std::vector<Isa> isas;
+    for (Isa isa : {Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (resolve_isa(isa) == isa) isas.push_back(isa);
+    }
+    static VoiceBank bank;
+    bank.clear(base.data());
+    bank.count = VoiceBank::kLanes;
+    for (int l = 0; l < VoiceBank::kLanes; ++l) {
+        bank.idxMask[l] = kTableSize - 1;
+        bank.inc[l] = 0x01000000u + (uint32_t)l * 0x00123457u;
+        bank.wA[l] = 0.75f;
+        bank.wB[l] = 0.25f;
+        bank.vel[l] = 1.0f;
+        for (int i = 0; i < VoiceBank::kMaxBlock; ++i) bank.env[i][l] = 0.5f;
+    }
+    constexpr int kFinishN = 128;
+    std::vector<float> outL(kFinishN), outR(kFinishN);
+    uint32_t rng = 1;
+
+    enum Kind { RenderBank, Finish };
+    struct Entry { const char* name; Kind kind; int n; float noise; };
+    const Entry entries[] = {{"render_bank", RenderBank, 64, 0.0f}, {"finish", Finish, kFinishN, 0.0f},
+                             {"finish_noise", Finish, kFinishN, 2.0f}};
+    bool ok = true;
+    for (const Entry& e : entries) {
+        const void* sse2Fn = nullptr;
+        double sse2Ns = 0.0;
+        for (Isa isa : isas) {
+            const DspKernels& k = dsp_kernels(isa);
+            const void* fn = e.kind == RenderBank ? (const void*)k.renderBank : (const void*)k.finish;
+            double ns = 0.0;
+            if (e.kind == RenderBank) {
+                ns = best_time_per_call(o.minTime, [&] { k.renderBank(bank, e.n); }) * 1e9;
+            } else {
+                ns = best_time_per_call(o.minTime, [&] {
+                    k.finish(bank.out[0], outL.data(), outR.data(), e.n, 0.5f, e.noise, 0.3f, rng);
+                }) * 1e9;
+            }
+            std::printf("{\"bench\":\"kernels\",\"entry\":\"%s\",\"n\":%d,\"isa\":\"%s\",\"ns_per_call\":%.2f",
+                        e.name, e.n, isa_name(isa), ns);
+            if (isa == Isa::SSE2) { sse2Fn = fn; sse2Ns = ns; }
+            if ((int)isa > (int)Isa::SSE2 && sse2Fn && fn != sse2Fn) {
+                const double ratio = ns / sse2Ns;
+                const bool slower = ratio > 1.10;
+                std::printf(",\"vs_sse2\":%.2f%s", ratio, slower ? ",\"regression\":true" : "");
+                if (slower && o.failOnRegression) ok = false;
+            }
+            std::printf("}\n");
+        }
+    }
+    std::fflush(stdout);
+    return ok;
+}
+
+// fastmath error bounds (the ones documented in fastmath.h) over each function's domain,
+// against the double-precision std:: version; with timed, also its speed next to the
+// float std:: version. Returns false on a violation. Without timing it is deterministic
+// (the fastmath_accuracy test runs it through --check-fastmath).
+bool run_fastmath(const Options& o, bool timed) {
+    constexpr int kN = 4096;
+    std::vector<float> xs(kN), ys(kN);
+    long iters = 0;
+    auto check_fn = [&](const char* name, float lo, float hi, bool relative, double bound, auto approx, auto stdf,
+                        auto exact) {
+        double err = 0.0;
+        for (int i = 0; i <= 1 << 20; ++i) {
+            const float x = lo + (hi - lo) * (float)((double)i / (double)(1 << 20));
+            const double r = exact((double)x);
+            double e = std::fabs((double)approx(x) - r);
+            if (relative) e /= std::fabs(r);
+            err = std::max(err, e);
+        }
+        const bool pass = err <= bound;
+        std::printf("{\"bench\":\"fastmath\",\"fn\":\"%s\",\"lo\":%g,\"hi\":%g,\"max_%s_err\":%.3g,\"bound\":%.3g",
+                    name, lo, hi, relative ? "rel" : "abs", err, bound);
+        if (timed) {
+            for (int i = 0; i < kN; ++i) xs[(size_t)i] = lo + (hi - lo) * (float)i / (float)(kN - 1);
+            const double tf = time_per_call(o.minTime, [&] {
+                for (int i = 0; i < kN; ++i) ys[(size_t)i] = approx(xs[(size_t)i]);
+                g_sink = g_sink + ys[kN / 2];
+            }, iters);
+            const double ts = time_per_call(o.minTime, [&] {
+                for (int i = 0; i < kN; ++i) ys[(size_t)i] = stdf(xs[(size_t)i]);
+                g_sink = g_sink + ys[kN / 2];
+            }, iters);
+            std::printf(",\"ns_fast\":%.2f,\"ns_std\":%.2f", tf * 1e9 / kN, ts * 1e9 / kN);
+        }
+        std::printf("%s}\n", pass ? "" : ",\"violation\":true");
+        return pass;
+    };
+    bool ok = check_fn("sin", -64.0f, 64.0f, false, 1.7e-7, [](float x) { return fastmath::sin(x); },
+                       [](float x) { return std::sin(x); }, [](double x) { return std::sin(x); });
+    ok = check_fn("exp2", -4.0f, 4.0f, true, 2.5e-7, [](float x) { return fastmath::exp2(x); },
+                  [](float x) { return std::exp2(x); }, [](double x) { return std::exp2(x); }) && ok;
+    // Note frequencies must be the correctly rounded 440 * 2^((note - 69) / 12)
+    int mismatches = 0;
+    for (int n = 0; n < 128; ++n) {
+        if (fastmath::midi_to_freq(n) != (float)(440.0 * std::exp2((double)(n - 69) / 12.0))) ++mismatches;
+    }
+    std::printf("{\"bench\":\"fastmath\",\"fn\":\"midi_to_freq\",\"notes\":128,\"mismatches\":%d%s}\n",
+                mismatches, mismatches ? ",\"violation\":true" : "");
+    std::fflush(stdout);
+    return ok && mismatches == 0;
+}
+
+bool run_micro(const Options& o) {
+    const Tables tables;
+    const Table& base = tables.get(15, true, 128);
+    long iters = 0;
+    char args[96];
+
+    if (selected(o, "build_bandlimited_set")) {
+        for (int bpo : {1, 4, 8}) {
+            const double t = time_per_call(o.minTime, [&] {
+                BLSet s = build_bandlimited_set(base, bpo);
+                g_sink = g_sink + s.tables.back()[1];
+            }, iters);
+            std::snprintf(args, sizeof(args), "\"bpo\":%d,", bpo);
+            print_micro("build_bandlimited_set", args, t, iters);
+        }
+    }
+    if (selected(o, "apply_lowpass_with_taper")) {
+        for (int h : {32, 128}) {
+            const double t = time_per_call(o.minTime, [&] {
+                Table f = apply_lowpass_with_taper(base, h, 8);
+                g_sink = g_sink + f[1];
+            }, iters);
+            std::snprintf(args, sizeof(args), "\"H\":%d,\"taper\":8,", h);
+            print_micro("apply_lowpass_with_taper", args, t, iters);
+        }
+    }
+    if (selected(o, "decimator")) {
+        // Block decimation as the HQ paths run it: cost per output sample
+        constexpr int kOut = 128;
+        std::vector<float> src((size_t)kOut * Decimator::kMaxOS), work(src.size()), out((size_t)kOut);
+        for (size_t i = 0; i < src.size(); ++i) src[i] = base[i % kTableSize];
+        for (int os : {2, 4, 8}) {
+            Decimator d;
+            d.configure(os);
+            const double t = time_per_call(o.minTime, [&] {
+                std::copy(src.begin(), src.begin() + kOut * os, work.begin());
+                d.process(work.data(), out.data(), kOut);
+                g_sink = g_sink + out[kOut - 1];
+            }, iters);
+            std::snprintf(args, sizeof(args), "\"os\":%d,", os);
+            std::printf("{\"bench\":\"decimator\",%s\"ns_per_output\":%.2f,\"iters\":%ld}\n", args,
+                        t * 1e9 / kOut, iters);
+        }
+    }
+    bool ok = true;
+    if (selected(o, "kernels")) ok = run_kernels(o, base) && ok;
+    if (selected(o, "fastmath")) ok = run_fastmath(o, true) && ok;
+    std::fflush(stdout);
+    return ok;
+}
+
+// Drive a realtime-mode Synth through every parameter combination the plug-in can send,
+// the way the audio thread does (setParams, notes and process() interleaved, table sets
+// swapped in from the builder thread). With MSM5232_RT_CHECK any allocation or lock in
+// those calls aborts with its location; reaching the end means the hot path is clean.
+int run_rt_check(const Options& o, int sr) {
+    if (!rtcheck::kEnabled) {
+        std::fprintf(stderr, "--rt-check needs a build configured with -DMSM5232_RT_CHECK=ON\n");
+        return 1;
+    }
+    Synth synth;
+    synth.setIsa(o.isa);
+    synth.setup((float)sr);
+    std::vector<float> L(1024), R(1024);
+    const int blocks[] = {1, 37, 64, 256, 1024};
+    const int polys[] = {1, 8, 32, 128};
+    SynthParams p;
+    p.gain = 0.1f;
+    long combos = 0;
+    for (int tone = 1; tone <= 15; ++tone) for (int quant = 0; quant <= 1; ++quant)
+    for (int table : {64, 128, 256}) for (int bl = 0; bl <= 8; ++bl)
+    for (int hq = 0; hq <= 4; ++hq) for (int path = 0; path <= 1; ++path)
+    for (int phc = 0; phc <= 2; ++phc) {
+        p.toneMask = tone;
+        p.quantize4 = quant != 0;
+        p.tableLen = table;
+        p.blQuality = bl;
+        p.hqMode = hq;
+        p.hqPath = path;
+        p.preHighCutMode = phc;
+        p.preHighCutMaxNote = 40 + (int)(combos % 80);
+        p.polyphony = polys[combos % 4];
+        p.adsr.attack = (combos & 1) ? 0.001f : 0.02f;
+        p.adsr.release = (combos & 2) ? 0.01f : 0.2f;
+        synth.setParams(p);
+        synth.setVibratoDepthSemis((float)(combos % 5) * 0.1f);
+        synth.setNoiseAdd((combos % 7 == 0) ? 0.5f : 0.0f);
+        synth.setPitchBendSemis((float)(combos % 9) * 0.5f - 2.0f);
+        // Enough notes to steal voices at low polyphony, over the whole keyboard
+        for (int k = 0; k < 12; ++k) synth.noteOn((int)((combos * 5 + k * 11) % 128), 1 + k * 10);
+        const int block = blocks[combos % 5];
+        synth.process(L.data(), R.data(), block);
+        for (int k = 0; k < 12; k += 2) synth.noteOff((int)((combos * 5 + k * 11) % 128));
+        synth.process(L.data(), R.data(), block);
+        ++combos;
+    }
+    // Let everything release and the builder catch up, then render until idle
+    for (int i = 0; i < sr * 2 && !synth.process(L.data(), R.data(), 256); i += 256) {}
+    std::printf("{\"bench\":\"rt_check\",\"combinations\":%ld,\"violations\":0}\n", combos);
+    return 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    const int sr = 48000;
+    Options o;
+    for (int a = 1; a < argc; ++a) {
+        if (std::strncmp(argv[a], "--isa=", 6) == 0) {
+            if (!parse_isa(argv[a] + 6, o.isa)) {
+                std::fprintf(stderr, "unknown ISA '%s' (auto|scalar|sse2|avx2|avx512)\n", argv[a] + 6);
+                return 1;
+            }
+        } else if (std::strncmp(argv[a], "--threads=", 10) == 0) {
+            o.threads = std::atoi(argv[a] + 10);
+            if (o.threads <= 0) o.threads = (int)std::thread::hardware_concurrency();
+        } else if (std::strncmp(argv[a], "--min-time=", 11) == 0) {
+            o.minTime = std::max(0.01, std::atof(argv[a] + 11));
+        } else if (std::strncmp(argv[a], "--filter=", 9) == 0) {
+            o.filter = argv[a] + 9;
+        } else if (std::strcmp(argv[a], "--full") == 0) {
+            o.full = true;
+        } else if (std::strcmp(argv[a], "--rt-check") == 0) {
+            o.rtCheck = true;
+        } else if (std::strcmp(argv[a], "--check-fastmath") == 0) {
+            o.checkFastmath = true;
+        } else if (std::strcmp(argv[a], "--fail-on-regression") == 0) {
+            o.failOnRegression = true;
+        } else {
+            std::fprintf(stderr,
+                         "usage: msm5232_bench [--isa=NAME] [--threads=N] [--min-time=SEC] [--filter=NAME] [--full] [--rt-check]\n"
+                         "                     [--fail-on-regression] [--check-fastmath]\n");
+            return 1;
+        }
+    }
+    std::printf("{\"bench\":\"meta\",\"isa\":\"%s\",\"threads\":%d,\"sample_rate\":%d,\"min_time\":%.3f}\n",
+                isa_name(resolve_isa(o.isa)), std::max(1, o.threads), sr, o.minTime);
+    if (o.rtCheck) return run_rt_check(o, sr);
+    if (o.checkFastmath) return run_fastmath(o, false) ? 0 : 1;
+    // Accuracy checks (and kernel regressions with --fail-on-regression) set the exit code,
+    // after the full run
+    const bool ok = run_micro(o);
+    if (selected(o, "process")) run_process_grid(o, sr);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+#include "app/midi_file.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace msm5232 {
+
+namespace {
+
+struct RawEvent {
+    uint64_t tick;
+    int track;
+    size_t seq;
+    uint8_t status, data1, data2;
+};
+
+struct TempoChange {
+    uint64_t tick;
+    uint32_t usPerQuarter;
+};
+
+uint32_t be32(const unsigned char* p) { return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3]; }
+uint16_t be16(const unsigned char* p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+// Variable-length quantity; false when it runs past end
+bool read_vlq(const unsigned char*& p, const unsigned char* end, uint32_t& out) {
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (p >= end) return false;
+        const unsigned char b = *p++;
+        out = (out << 7) | (b & 0x7F);
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool parse_track(const unsigned char* p, const unsigned char* end, int track, std::vector<RawEvent>& events,
+                 std::vector<TempoChange>& tempos) {
+    uint64_t tick = 0;
+    uint8_t running = 0;
+    while (p < end) {
+        uint32_t delta;
+        if (!read_vlq(p, end, delta)) return false;
+        tick += delta;
+        if (p >= end) return false;
+        uint8_t status = *p;
+        if (status == 0xFF) { // meta
+            if (end - p < 2) return false;
+            const uint8_t type = p[1];
+            p += 2;
+            uint32_t len;
+            if (!read_vlq(p, end, len) || (uint32_t)(end - p) < len) return false;
+            if (type == 0x51 && len == 3) tempos.push_back({tick, (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2]});
+            p += len;
+            if (type == 0x2F) break; // end of track
+            continue;
+        }
+        if (status == 0xF0 || status == 0xF7) { // SysEx
+            ++p;
+            uint32_t len;
+            if (!read_vlq(p, end, len) || (uint32_t)(end - p) < len) return false;
+            p += len;
+            running = 0;
+            continue;
+        }
+        if (status & 0x80) {
+            ++p;
+            running = status;
+        } else if (running) {
+            status = running; // running status: p already points at data1
+        } else {
+            return false;
+        }
+        const uint8_t type = status & 0xF0;
+        const int nData = (type == 0xC0 || type == 0xD0) ? 1 : 2;
+        if (end - p < nData) return false;
+        RawEvent e{tick, track, events.size(), status, p[0], (uint8_t)(nData == 2 ? p[1] : 0)};
+        p += nData;
+        events.push_back(e);
+    }
+    return true;
+}
+
+}
+
+bool read_midi_file(const std::string& path, std::vector<MidiEvent>& out, std::string& err) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) { err = "cannot open " + path; return false; }
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const unsigned char* p = data.data();
+    const unsigned char* end = p + data.size();
+    if (data.size() < 14 || std::string((const char*)p, 4) != "MThd" || be32(p + 4) < 6) {
+        err = path + ": not a Standard MIDI File";
+        return false;
+    }
+    const uint16_t format = be16(p + 8);
+    const uint16_t ntrks = be16(p + 10);
+    const uint16_t division = be16(p + 12);
+    if (format > 1) { err = path + ": SMF format 2 is not supported"; return false; }
+    if (be32(p + 4) > (uint32_t)(end - p - 8)) { err = path + ": truncated header"; return false; }
+    if (division & 0x8000) {
+        // SMPTE: -fps in the high byte, ticks per frame in the low byte
+        const int fps = -(int)(int8_t)(division >> 8);
+        if ((fps != 24 && fps != 25 && fps != 29 && fps != 30) || (division & 0xFF) == 0) {
+            err = path + ": invalid SMPTE time division";
+            return false;
+        }
+    }
+    p += 8 + be32(p + 4);
+
+    std::vector<RawEvent> raw;
+    std::vector<TempoChange> tempos;
+    for (int track = 0; track < ntrks && p < end; ) {
+        // Every chunk header and length must fit in what is left of the file
+        if (end - p < 8) { err = path + ": truncated chunk header"; return false; }
+        const uint32_t len = be32(p + 4);
+        const bool isTrack = std::string((const char*)p, 4) == "MTrk";
+        p += 8;
+        if ((uint32_t)(end - p) < len) { err = path + ": truncated chunk"; return false; }
+        if (isTrack) {
+            if (!parse_track(p, p + len, track, raw, tempos)) {
+                err = path + ": malformed track " + std::to_string(track);
+                return false;
+            }
+            ++track;
+        }
+        p += len; // unknown chunks are skipped
+    }
+
+    // Time order; file order (track, then position) for equal ticks
+    std::stable_sort(raw.begin(), raw.end(), [](const RawEvent& a, const RawEvent& b) {
+        if (a.tick != b.tick) return a.tick < b.tick;
+        if (a.track != b.track) return a.track < b.track;
+        return a.seq < b.seq;
+    });
+    std::stable_sort(tempos.begin(), tempos.end(), [](const TempoChange& a, const TempoChange& b) { return a.tick < b.tick; });
+
+    out.clear();
+    out.reserve(raw.size());
+    if (division & 0x8000) {
+        // SMPTE (validated above): 29 = 29.97 drop frame
+        const int fps = -(int)(int8_t)(division >> 8);
+        const double framesPerSec = (fps == 29) ? 29.97 : (double)fps;
+        const double ticksPerSec = framesPerSec * (double)(division & 0xFF);
+        for (const RawEvent& e : raw) out.push_back({(double)e.tick / ticksPerSec, e.status, e.data1, e.data2});
+        return true;
+    }
+    // PPQ: walk the tempo map (default 120 bpm)
+    const double ppq = division ? (double)division : 480.0;
+    double secPerTick = 0.5 / ppq;
+    double baseSec = 0.0;
+    uint64_t baseTick = 0;
+    size_t t = 0;
+    for (const RawEvent& e : raw) {
+        while (t < tempos.size() && tempos[t].tick <= e.tick) {
+            baseSec += (double)(tempos[t].tick - baseTick) * secPerTick;
+            baseTick = tempos[t].tick;
+            secPerTick = (double)tempos[t].usPerQuarter * 1e-6 / ppq;
+            ++t;
+        }
+        out.push_back({baseSec + (double)(e.tick - baseTick) * secPerTick, e.status, e.data1, e.data2});
+    }
+    return true;
+}
+
+}
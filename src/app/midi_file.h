@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace msm5232 {
+
+// Channel voice message from a Standard MIDI File, timed in seconds
+struct MidiEvent {
+    double seconds = 0.0;
+    uint8_t status = 0; // 0x80..0xEF (type | channel)
+    uint8_t data1 = 0;
+    uint8_t data2 = 0;
+};
+
+// Read an SMF (format 0 or 1, PPQ or SMPTE timing). Tracks are merged and every
+// channel message is returned in time order (file order for equal times), with
+// tempo changes applied. Meta and SysEx events are consumed, not returned.
+bool read_midi_file(const std::string& path, std::vector<MidiEvent>& events, std::string& err);
+
+}
@@ -1,71 +1,142 @@
 #include "dsp/synth.h"
+#include "app/wav_writer.h"
+#include "app/batch_render.h"
+#include "app/midi_file.h"
 #include <vector>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
 #include <string>
+#include <thread>
 
 using namespace msm5232;
 
-static void write_u32_le(FILE* f, uint32_t v) { std::fwrite(&v, 1, 4, f); }
-static void write_u16_le(FILE* f, uint16_t v) { std::fwrite(&v, 1, 2, f); }
-
-static bool write_wav24(const std::string& path, const std::vector<float>& L, const std::vector<float>& R, int sr) {
-    if (L.size() != R.size()) return false;
-    uint32_t frames = (uint32_t)L.size();
-    uint16_t channels = 2;
-    uint16_t bitsPerSample = 24;
-    uint16_t blockAlign = channels * (bitsPerSample / 8);
-    uint32_t byteRate = sr * blockAlign;
-    uint32_t dataBytes = frames * blockAlign;
-
-    FILE* f = std::fopen(path.c_str(), "wb");
-    if (!f) return false;
-    std::fwrite("RIFF", 1, 4, f);
-    write_u32_le(f, 36 + dataBytes);
-    std::fwrite("WAVE", 1, 4, f);
-    std::fwrite("fmt ", 1, 4, f);
-    write_u32_le(f, 16);
-    write_u16_le(f, 1); // PCM
-    write_u16_le(f, channels);
-    write_u32_le(f, sr);
-    write_u32_le(f, byteRate);
-    write_u16_le(f, blockAlign);
-    write_u16_le(f, bitsPerSample);
-    std::fwrite("data", 1, 4, f);
-    write_u32_le(f, dataBytes);
-
-    auto write24 = [&](float x) {
-        float clamped = x;
-        if (clamped > 0.999999f) clamped = 0.999999f;
-        if (clamped < -0.999999f) clamped = -0.999999f;
-        int32_t v = static_cast<int32_t>(clamped * 8388607.0f);
-        unsigned char b[3];
-        b[0] = (unsigned char)(v & 0xFF);
-        b[1] = (unsigned char)((v >> 8) & 0xFF);
-        b[2] = (unsigned char)((v >> 16) & 0xFF);
-        std::fwrite(b, 1, 3, f);
-    };
+// Apply one channel message the way the VST3 processor maps it (all channels drive the one synth)
+static void apply_midi_event(Synth& synth, const MidiEvent& e) {
+    switch (e.status & 0xF0) {
+        case 0x90:
+            if (e.data2 > 0) { synth.noteOn(e.data1, e.data2); break; }
+            synth.noteOff(e.data1); // velocity 0 = note off
+            break;
+        case 0x80: synth.noteOff(e.data1); break;
+        case 0xE0: {
+            // +/-2 semitones, center 8192
+            const int v = e.data1 | (e.data2 << 7);
+            synth.setPitchBendSemis(((float)v / 16383.0f - 0.5f) * 4.0f);
+        } break;
+        case 0xB0: {
+            const float x = (float)e.data2 / 127.0f;
+            if (e.data1 == 1) synth.setDetuneSemis(x - 0.5f);        // CC#1: Detune
+            else if (e.data1 == 24) synth.setVibratoDepthSemis(x * 0.5f); // CC#24: Vibrato Depth
+            else if (e.data1 == 25) synth.setVibratoRateHz(x * 16.0f);    // CC#25: Vibrato Rate
+        } break;
+        default: break;
+    }
+}
 
-    for (uint32_t i = 0; i < frames; ++i) {
-        write24(L[i]);
-        write24(R[i]);
+// Render events with sample-accurate timing, then run until the release tails are silent
+// (at most maxTailSeconds after the last event)
+static bool render_midi(Synth& synth, const std::vector<MidiEvent>& events, WavWriter& wav, int sr,
+                        float maxTailSeconds) {
+    float L[256], R[256];
+    int64_t pos = 0;
+    size_t next = 0;
+    while (next < events.size()) {
+        const int64_t at = (int64_t)(events[next].seconds * (double)sr + 0.5);
+        if (at <= pos) { apply_midi_event(synth, events[next++]); continue; }
+        const int n = (int)std::min<int64_t>(256, at - pos);
+        synth.process(L, R, n);
+        if (!wav.write(L, R, n)) return false;
+        pos += n;
+    }
+    const int64_t tailEnd = pos + (int64_t)(maxTailSeconds * (float)sr);
+    while (pos < tailEnd) {
+        const int n = (int)std::min<int64_t>(256, tailEnd - pos);
+        const bool silent = synth.process(L, R, n);
+        if (!wav.write(L, R, n)) return false;
+        pos += n;
+        if (silent) break;
     }
-    std::fclose(f);
     return true;
 }
 
+static int usage(const char* arg) {
+    std::fprintf(stderr, "unknown option '%s'\n"
+                 "usage: msm5232_render [--isa=NAME] [--threads=N] [--format=pcm16|pcm24|float32]\n"
+                 "                      [--out=FILE] [--midi=FILE | --batch=SPEC] [toneMask 1..15]\n", arg);
+    return 1;
+}
+
 int main(int argc, char** argv) {
     int sr = 48000;
     float seconds = 4.0f;
     int tone = 15; // default all combined
-    if (argc > 1) tone = std::atoi(argv[1]);
+    Isa isa = Isa::Auto;
+    int threads = 1;
+    bool threadsSet = false;
+    std::string batchSpec;
+    std::string midiPath;
+    std::string outPath = "render.wav";
+    WavFormat format = WavFormat::Pcm24;
+    for (int a = 1; a < argc; ++a) {
+        if (std::strncmp(argv[a], "--isa=", 6) == 0) {
+            if (!parse_isa(argv[a] + 6, isa)) {
+                std::fprintf(stderr, "unknown ISA '%s' (auto|scalar|sse2|avx2|avx512)\n", argv[a] + 6);
+                return 1;
+            }
+        } else if (std::strncmp(argv[a], "--threads=", 10) == 0) {
+            threads = std::atoi(argv[a] + 10);
+            if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+            threadsSet = true;
+        } else if (std::strncmp(argv[a], "--format=", 9) == 0) {
+            if (!parse_wav_format(argv[a] + 9, format)) {
+                std::fprintf(stderr, "unknown format '%s' (pcm16|pcm24|float32)\n", argv[a] + 9);
+                return 1;
+            }
+        } else if (std::strncmp(argv[a], "--midi=", 7) == 0) {
+            midiPath = argv[a] + 7;
+        } else if (std::strncmp(argv[a], "--out=", 6) == 0) {
+            outPath = argv[a] + 6;
+        } else if (std::strncmp(argv[a], "--batch=", 8) == 0) {
+            batchSpec = argv[a] + 8;
+        } else if (std::strncmp(argv[a], "--", 2) == 0) {
+            return usage(argv[a]);
+        } else {
+            tone = std::atoi(argv[a]);
+        }
+    }
     if (tone < 1 || tone > 15) tone = 15;
 
+    if (!batchSpec.empty()) {
+        // Batch: one file per job, jobs spread over all cores unless --threads is given
+        std::vector<BatchJob> jobs;
+        std::string err;
+        if (!parse_batch_spec(batchSpec, jobs, err)) {
+            std::fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+        if (!threadsSet) threads = std::max(1, (int)std::thread::hardware_concurrency());
+        std::printf("kernels: %s, %zu jobs on %d threads\n", isa_name(resolve_isa(isa)), jobs.size(), threads);
+        int failed = run_batch(jobs, sr, isa, format, threads);
+        return failed ? 1 : 0;
+    }
+
+    std::vector<MidiEvent> events;
+    if (!midiPath.empty()) {
+        std::string err;
+        if (!read_midi_file(midiPath, events, err)) {
+            std::fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+    }
+
     Synth synth;
     SynthParams p;
     p.toneMask = tone;
-    p.polyphony = 32;
+    // Songs may stack more notes than the demo chord: use the whole voice pool
+    p.polyphony = midiPath.empty() ? 32 : synth.voiceCount();
     // 補間なしテーブルは64/128をサポート（既定は128）
     p.tableLen = 128;
     p.quantize4 = true;
@@ -74,23 +145,47 @@ int main(int argc, char** argv) {
     p.adsr.sustain = 0.6f;
     p.adsr.release = 0.3f;
     p.gain = 0.3f;
+    // Offline render: rebuild tables synchronously so output is deterministic
+    synth.setRealtime(false);
+    synth.setIsa(isa);
+    // Voice slices render on a worker pool; output is identical for any thread count
+    synth.setRenderThreads(threads);
     synth.setup((float)sr);
+    std::printf("kernels: %s\n", isa_name(synth.isa()));
     synth.setParams(p);
 
-    std::vector<int> notes = {60, 64, 67, 71, 74, 77, 81, 84};
-    for (int n : notes) synth.noteOn(n, 100);
-
-    int total = int(seconds * sr);
-    std::vector<float> L(total), R(total);
-    int offSample = int(2.0f * sr);
-    for (int i = 0; i < total; i += 64) {
-        int block = std::min(64, total - i);
-        synth.process(L.data() + i, R.data() + i, block);
-        if (i < offSample && i + 64 >= offSample) {
-            for (int n : notes) synth.noteOff(n);
+    // Stream to disk block by block (constant memory for any length)
+    WavWriter wav;
+    if (!wav.open(outPath, sr, format)) {
+        std::fprintf(stderr, "cannot write %s\n", outPath.c_str());
+        return 1;
+    }
+    if (!midiPath.empty()) {
+        if (!render_midi(synth, events, wav, sr, 10.0f)) {
+            std::fprintf(stderr, "error writing %s\n", outPath.c_str());
+            return 1;
+        }
+    } else {
+        std::vector<int> notes = {60, 64, 67, 71, 74, 77, 81, 84};
+        for (int n : notes) synth.noteOn(n, 100);
+        int total = int(seconds * sr);
+        int offSample = int(2.0f * sr);
+        float L[64], R[64];
+        for (int i = 0; i < total; i += 64) {
+            int block = std::min(64, total - i);
+            synth.process(L, R, block);
+            if (!wav.write(L, R, block)) {
+                std::fprintf(stderr, "error writing %s\n", outPath.c_str());
+                return 1;
+            }
+            if (i < offSample && i + 64 >= offSample) {
+                for (int n : notes) synth.noteOff(n);
+            }
         }
     }
-
-    write_wav24("render.wav", L, R, sr);
+    if (!wav.close()) {
+        std::fprintf(stderr, "error writing %s\n", outPath.c_str());
+        return 1;
+    }
     return 0;
 }
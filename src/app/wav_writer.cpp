@@ -0,0 +1,143 @@
+#include "app/wav_writer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace msm5232 {
+
+namespace {
+
+inline unsigned char* put_u16_le(unsigned char* p, uint16_t v) {
+    p[0] = (unsigned char)(v & 0xFF);
+    p[1] = (unsigned char)(v >> 8);
+    return p + 2;
+}
+inline unsigned char* put_u32_le(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char)((v >> (8 * i)) & 0xFF);
+    return p + 4;
+}
+inline float clamp_unit(float x) {
+    if (x > 0.999999f) x = 0.999999f;
+    if (x < -0.999999f) x = -0.999999f;
+    return x;
+}
+
+}
+
+bool parse_wav_format(const char* name, WavFormat& out) {
+    if (std::strcmp(name, "pcm16") == 0) { out = WavFormat::Pcm16; return true; }
+    if (std::strcmp(name, "pcm24") == 0) { out = WavFormat::Pcm24; return true; }
+    if (std::strcmp(name, "float32") == 0) { out = WavFormat::Float32; return true; }
+    return false;
+}
+
+bool WavWriter::open(const std::string& path, int sampleRate, WavFormat format) {
+    close();
+    f_ = std::fopen(path.c_str(), "wb");
+    if (!f_) return false;
+    // The staging buffer already batches writes; skip stdio's copy
+    std::setvbuf(f_, nullptr, _IONBF, 0);
+    format_ = format;
+    sampleRate_ = sampleRate;
+    bytesPerSample_ = (format == WavFormat::Pcm16) ? 2 : (format == WavFormat::Pcm24) ? 3 : 4;
+    stage_.resize(kStageBytes);
+    fill_ = 0;
+    frames_ = 0;
+    ok_ = true;
+    // Placeholder sizes, patched by close()
+    writeHeader();
+    return ok_;
+}
+
+// RIFF/fmt (+fact for float)/data header for the current frame count
+void WavWriter::writeHeader() {
+    const uint16_t channels = 2;
+    const uint16_t blockAlign = (uint16_t)(channels * bytesPerSample_);
+    const bool isFloat = format_ == WavFormat::Float32;
+    const uint64_t data64 = frames_ * blockAlign;
+    const uint32_t headerBytes = isFloat ? 58u : 44u;
+    const uint32_t dataBytes = (uint32_t)std::min<uint64_t>(data64, 0xFFFFFFFFull - headerBytes);
+    unsigned char h[58];
+    unsigned char* p = h;
+    std::memcpy(p, "RIFF", 4); p += 4;
+    p = put_u32_le(p, headerBytes - 8 + dataBytes);
+    std::memcpy(p, "WAVE", 4); p += 4;
+    std::memcpy(p, "fmt ", 4); p += 4;
+    p = put_u32_le(p, isFloat ? 18 : 16);
+    p = put_u16_le(p, isFloat ? 3 : 1); // IEEE float / PCM
+    p = put_u16_le(p, channels);
+    p = put_u32_le(p, (uint32_t)sampleRate_);
+    p = put_u32_le(p, (uint32_t)sampleRate_ * blockAlign);
+    p = put_u16_le(p, blockAlign);
+    p = put_u16_le(p, (uint16_t)(bytesPerSample_ * 8));
+    if (isFloat) {
+        p = put_u16_le(p, 0); // cbSize
+        std::memcpy(p, "fact", 4); p += 4;
+        p = put_u32_le(p, 4);
+        p = put_u32_le(p, (uint32_t)std::min<uint64_t>(frames_, 0xFFFFFFFFull));
+    }
+    std::memcpy(p, "data", 4); p += 4;
+    p = put_u32_le(p, dataBytes);
+    if (std::fwrite(h, 1, (size_t)(p - h), f_) != (size_t)(p - h)) ok_ = false;
+}
+
+bool WavWriter::write(const float* L, const float* R, int frames) {
+    if (!f_ || !ok_) return false;
+    const size_t frameBytes = 2 * (size_t)bytesPerSample_;
+    for (int i = 0; i < frames;) {
+        if (fill_ + frameBytes > stage_.size() && !flush()) return false;
+        const int n = std::min(frames - i, (int)((stage_.size() - fill_) / frameBytes));
+        unsigned char* p = stage_.data() + fill_;
+        switch (format_) {
+            case WavFormat::Pcm16:
+                for (int k = i; k < i + n; ++k) {
+                    p = put_u16_le(p, (uint16_t)(int16_t)(clamp_unit(L[k]) * 32767.0f));
+                    p = put_u16_le(p, (uint16_t)(int16_t)(clamp_unit(R[k]) * 32767.0f));
+                }
+                break;
+            case WavFormat::Pcm24:
+                for (int k = i; k < i + n; ++k) {
+                    for (float x : {L[k], R[k]}) {
+                        int32_t v = static_cast<int32_t>(clamp_unit(x) * 8388607.0f);
+                        p[0] = (unsigned char)(v & 0xFF);
+                        p[1] = (unsigned char)((v >> 8) & 0xFF);
+                        p[2] = (unsigned char)((v >> 16) & 0xFF);
+                        p += 3;
+                    }
+                }
+                break;
+            case WavFormat::Float32:
+                for (int k = i; k < i + n; ++k) {
+                    uint32_t a, b;
+                    std::memcpy(&a, &L[k], 4);
+                    std::memcpy(&b, &R[k], 4);
+                    p = put_u32_le(p, a);
+                    p = put_u32_le(p, b);
+                }
+                break;
+        }
+        fill_ = (size_t)(p - stage_.data());
+        frames_ += (uint64_t)n;
+        i += n;
+    }
+    return ok_;
+}
+
+bool WavWriter::flush() {
+    if (fill_ > 0 && std::fwrite(stage_.data(), 1, fill_, f_) != fill_) ok_ = false;
+    fill_ = 0;
+    return ok_;
+}
+
+bool WavWriter::close() {
+    if (!f_) return ok_;
+    flush();
+    if (std::fseek(f_, 0, SEEK_SET) == 0) writeHeader();
+    else ok_ = false;
+    if (std::fclose(f_) != 0) ok_ = false;
+    f_ = nullptr;
+    stage_.clear();
+    stage_.shrink_to_fit();
+    return ok_;
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace msm5232 {
+
+enum class WavFormat { Pcm16, Pcm24, Float32 };
+
+// "pcm16", "pcm24", "float32"; returns false for unknown names
+bool parse_wav_format(const char* name, WavFormat& out);
+
+// Streaming stereo WAV writer: samples are converted and interleaved into a large
+// staging buffer that is written in big chunks; close() patches the RIFF sizes, so
+// renders of any length run in constant memory. Sizes are clamped at the 4 GiB RIFF limit.
+class WavWriter {
+public:
+    WavWriter() = default;
+    ~WavWriter() { close(); }
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    bool open(const std::string& path, int sampleRate, WavFormat format);
+    // Append frames of L/R; false after any write error
+    bool write(const float* L, const float* R, int frames);
+    // Flush and finalize the header; false if anything failed since open()
+    bool close();
+
+private:
+    static constexpr size_t kStageBytes = 256 * 1024;
+    bool flush();
+    void writeHeader();
+
+    FILE* f_ = nullptr;
+    WavFormat format_ = WavFormat::Pcm24;
+    int sampleRate_ = 48000;
+    int bytesPerSample_ = 3;
+    std::vector<unsigned char> stage_;
+    size_t fill_ = 0;
+    uint64_t frames_ = 0;
+    bool ok_ = false;
+};
+
+}
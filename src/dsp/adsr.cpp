@@ -1,8 +1,24 @@
 #include "dsp/adsr.h"
 #include <algorithm>
+#include <cmath>
 
 namespace msm5232 {
 
+namespace {
+constexpr float kReleaseFloor = 1e-5f; // release ends below this level
+}
+
+void ADSR::update() {
+    auto rate = [this](float seconds) { return (seconds <= 1e-5f) ? 1.0f : 1.0f / (seconds * sr_); };
+    sustain_ = std::clamp(p_.sustain, 0.0f, 1.0f);
+    attackStep_ = rate(p_.attack);
+    decayStep_ = rate(p_.decay) * (1.0f - sustain_);
+    releaseMul_ = std::max(0.0f, 1.0f - rate(p_.release));
+    releaseLog_ = releaseMul_ > 0.0f ? std::log(releaseMul_) : 0.0f;
+    releasePow_[0] = releaseMul_;
+    for (int j = 1; j < 4; ++j) releasePow_[j] = releasePow_[j - 1] * releaseMul_;
+}
+
 void ADSR::gate(bool on) {
     if (on) {
         state_ = Attack;
@@ -11,32 +27,62 @@ void ADSR::gate(bool on) {
     }
 }
 
-float ADSR::process() {
+int ADSR::stageLength() const {
+    constexpr float kMax = 1 << 30;
+    float m = 1.0f;
     switch (state_) {
-        case Idle:
-            env_ = 0.0f; break;
-        case Attack: {
-            float step = (p_.attack <= 1e-5f) ? 1.0f : 1.0f / (p_.attack * sr_);
-            env_ += step;
-            if (env_ >= 1.0f) { env_ = 1.0f; state_ = Decay; }
-        } break;
-        case Decay: {
-            float target = std::clamp(p_.sustain, 0.0f, 1.0f);
-            float step = (p_.decay <= 1e-5f) ? 1.0f : 1.0f / (p_.decay * sr_);
-            env_ -= step * (1.0f - target);
-            if (env_ <= target) { env_ = target; state_ = Sustain; }
-        } break;
-        case Sustain:
-            // hold
+        case Attack: m = std::ceil((1.0f - env_) / attackStep_); break;
+        case Decay: m = decayStep_ > 0.0f ? std::ceil((env_ - sustain_) / decayStep_) : 1.0f; break;
+        case Release:
+            if (releaseMul_ > 0.0f && env_ > kReleaseFloor) m = std::ceil(std::log(kReleaseFloor / env_) / releaseLog_);
             break;
-        case Release: {
-            float step = (p_.release <= 1e-5f) ? 1.0f : 1.0f / (p_.release * sr_);
-            env_ -= step * std::max(env_, 0.0f);
-            if (env_ <= 1e-5f) { env_ = 0.0f; state_ = Idle; }
-        } break;
+        default: return 1 << 30;
     }
-    return env_;
+    return (int)std::max(1.0f, std::min(m, kMax));
 }
 
+void ADSR::processBlock(float* out, int n, int stride) {
+    int i = 0;
+    while (i < n) {
+        if (state_ == Idle || state_ == Sustain) {
+            if (state_ == Idle) env_ = 0.0f;
+            const float e = env_;
+            for (; i < n; ++i) out[i * stride] = e;
+            return;
+        }
+        const int left = stageLength();
+        const int run = std::min(left, n - i);
+        // All but the stage's last sample in closed form; that one lands on the target
+        const int body = (run == left) ? run - 1 : run;
+        const float e0 = env_;
+        float* o = out + i * stride;
+        if (state_ == Attack) {
+            for (int k = 0; k < body; ++k) o[k * stride] = std::min(1.0f, e0 + attackStep_ * (float)(k + 1));
+            env_ = std::min(1.0f, e0 + attackStep_ * (float)body);
+        } else if (state_ == Decay) {
+            for (int k = 0; k < body; ++k) o[k * stride] = std::max(sustain_, e0 - decayStep_ * (float)(k + 1));
+            env_ = std::max(sustain_, e0 - decayStep_ * (float)body);
+        } else {
+            // Four samples per step from the precomputed powers (no serial dependency inside)
+            float e = e0;
+            int k = 0;
+            for (; k + 4 <= body; k += 4) {
+                for (int j = 0; j < 4; ++j) o[(k + j) * stride] = e * releasePow_[j];
+                e *= releasePow_[3];
+            }
+            for (; k < body; ++k) { e *= releaseMul_; o[k * stride] = e; }
+            env_ = e;
+        }
+        i += body;
+        if (run == left) {
+            // Stage end: land exactly on the target and move to the next stage
+            if (state_ == Attack) { env_ = 1.0f; state_ = Decay; }
+            else if (state_ == Decay) { env_ = sustain_; state_ = Sustain; }
+            else { env_ = 0.0f; state_ = Idle; }
+            out[i * stride] = env_;
+            ++i;
+        }
+    }
 }
 
+}
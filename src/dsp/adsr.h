@@ -9,20 +9,33 @@ struct ADSRParams {
     float release = 0.2f;
 };
 
+// Linear attack and decay, exponential release. Per-stage coefficients are computed in
+// set()/setSampleRate(), so the per-sample work is a single add or multiply.
 class ADSR {
 public:
-    void setSampleRate(float sr) { sr_ = sr > 1.0f ? sr : 48000.0f; }
-    void set(const ADSRParams& p) { p_ = p; }
+    void setSampleRate(float sr) { sr_ = sr > 1.0f ? sr : 48000.0f; update(); }
+    void set(const ADSRParams& p) { p_ = p; update(); }
     void gate(bool on);
-    float process();
+    // Next n envelope samples, written to out[i * stride]: the samples left in the current
+    // stage are filled as one closed-form run (constant during sustain)
+    void processBlock(float* out, int n, int stride = 1);
     bool isActive() const { return state_ != Idle; }
 private:
     enum State { Idle, Attack, Decay, Sustain, Release };
+    void update();
+    // Samples until the current stage ends (the last one lands exactly on the stage target)
+    int stageLength() const;
     State state_ = Idle;
     ADSRParams p_{};
     float sr_ = 48000.0f;
     float env_ = 0.0f;
+    // Stage coefficients (update())
+    float attackStep_ = 1.0f;  // added per sample
+    float decayStep_ = 1.0f;   // subtracted per sample, (1 - sustain) / decay samples
+    float sustain_ = 0.7f;     // clamped to 0..1
+    float releaseMul_ = 0.0f;  // env *= releaseMul_ per sample
+    float releaseLog_ = 0.0f;  // log(releaseMul_), for the release length
+    float releasePow_[4] = {0.0f, 0.0f, 0.0f, 0.0f}; // releaseMul_^1..4
 };
 
 }
-
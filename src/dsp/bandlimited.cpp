@@ -3,6 +3,112 @@
 
 namespace msm5232 {
 
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr int kHalf = kTableSize / 2; // bins 0..kHalf of a real spectrum
+
+using Spectrum = std::array<std::complex<float>, kHalf + 1>;
+
+// Radix-2 real-input FFT for N = kTableSize.
+// The real sequence is packed into a complex sequence of length N/2 (even samples in
+// the real part, odd in the imaginary part), transformed with an iterative radix-2 FFT
+// and split into bins 0..N/2. Twiddles and the bit-reversal permutation are precomputed.
+class RealFFT {
+public:
+    static const RealFFT& instance() {
+        static const RealFFT fft;
+        return fft;
+    }
+    // Unnormalized forward DFT: X[k] = sum x[n] e^{-2pi i kn/N}, k = 0..N/2
+    void forward(const Table& x, Spectrum& X) const {
+        std::array<std::complex<float>, kHalf> z;
+        for (int n = 0; n < kHalf; ++n) z[(size_t)rev_[(size_t)n]] = {x[(size_t)(2 * n)], x[(size_t)(2 * n + 1)]};
+        transform(z, false);
+        for (int k = 0; k <= kHalf; ++k) {
+            std::complex<float> a = z[(size_t)(k % kHalf)];
+            std::complex<float> b = std::conj(z[(size_t)((kHalf - k) % kHalf)]);
+            std::complex<float> even = 0.5f * (a + b);
+            std::complex<float> odd = std::complex<float>(0.0f, -0.5f) * (a - b);
+            X[(size_t)k] = even + split_[(size_t)k] * odd;
+        }
+    }
+    // Inverse of forward() including the 1/N scale; returns the real signal
+    void inverse(const Spectrum& X, Table& x) const {
+        std::array<std::complex<float>, kHalf> z;
+        for (int k = 0; k < kHalf; ++k) {
+            std::complex<float> a = X[(size_t)k];
+            std::complex<float> b = std::conj(X[(size_t)(kHalf - k)]);
+            std::complex<float> even = 0.5f * (a + b);
+            std::complex<float> odd = 0.5f * (a - b) * std::conj(split_[(size_t)k]);
+            z[(size_t)rev_[(size_t)k]] = even + std::complex<float>(0.0f, 1.0f) * odd;
+        }
+        transform(z, true);
+        const float scale = 1.0f / float(kHalf);
+        for (int n = 0; n < kHalf; ++n) {
+            x[(size_t)(2 * n)] = z[(size_t)n].real() * scale;
+            x[(size_t)(2 * n + 1)] = z[(size_t)n].imag() * scale;
+        }
+    }
+private:
+    RealFFT() {
+        int bits = 0;
+        while ((1 << bits) < kHalf) ++bits;
+        for (int i = 0; i < kHalf; ++i) {
+            int r = 0;
+            for (int b = 0; b < bits; ++b) if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+            rev_[(size_t)i] = r;
+        }
+        for (int j = 0; j < kHalf / 2; ++j) {
+            double a = -2.0 * kPi * double(j) / double(kHalf);
+            tw_[(size_t)j] = {(float)std::cos(a), (float)std::sin(a)};
+        }
+        for (int k = 0; k <= kHalf; ++k) {
+            double a = -2.0 * kPi * double(k) / double(kTableSize);
+            split_[(size_t)k] = {(float)std::cos(a), (float)std::sin(a)};
+        }
+    }
+    // In-place iterative radix-2 FFT on bit-reversed input (inverse: conjugate twiddles, unscaled)
+    void transform(std::array<std::complex<float>, kHalf>& a, bool inv) const {
+        for (int len = 2; len <= kHalf; len <<= 1) {
+            const int halfLen = len >> 1;
+            const int step = kHalf / len;
+            for (int i = 0; i < kHalf; i += len) {
+                for (int j = 0; j < halfLen; ++j) {
+                    std::complex<float> w = tw_[(size_t)(j * step)];
+                    if (inv) w = std::conj(w);
+                    std::complex<float> u = a[(size_t)(i + j)];
+                    std::complex<float> v = a[(size_t)(i + j + halfLen)] * w;
+                    a[(size_t)(i + j)] = u + v;
+                    a[(size_t)(i + j + halfLen)] = u - v;
+                }
+            }
+        }
+    }
+    std::array<int, kHalf> rev_{};
+    std::array<std::complex<float>, kHalf / 2> tw_{};
+    std::array<std::complex<float>, kHalf + 1> split_{};
+};
+
+// Low-pass X in place: keep up to H, raised-cosine taper over [H - taperBins .. H], zero above.
+// H >= Nyquist keeps everything (no taper).
+void apply_taper(Spectrum& Y, int H, int taperBins) {
+    if (H >= kHalf) return;
+    int startTaper = std::max(1, H - taperBins);
+    for (int k = 1; k <= kHalf; ++k) {
+        if (k > H) {
+            Y[(size_t)k] = std::complex<float>(0.0f, 0.0f);
+        } else if (k >= startTaper) {
+            // raised-cosine from 1 -> 0 across [startTaper .. H]
+            float t = float(k - startTaper) / float(std::max(1, H - startTaper));
+            float w = 0.5f * (1.0f + std::cos(3.14159265358979323846f * t));
+            Y[(size_t)k] *= w;
+        }
+    }
+}
+
+} // namespace
+
 static float compute_rms(const Table& t) {
     double acc = 0.0;
     for (float v : t) acc += double(v) * double(v);
@@ -34,20 +140,10 @@ std::vector<int> make_harmonic_cuts(int bandsPerOctave) {
 }
 
 BLSet build_bandlimited_set(const Table& base, int bandsPerOctave, bool normalizeRMS) {
-    const int N = (int)base.size();
-    // Forward DFT (naive, one-time); store complex spectrum X[k]
-    std::vector<std::complex<float>> X(N);
-    const float twoPiOverN = 2.0f * 3.14159265358979323846f / (float)N;
-    for (int k = 0; k < N; ++k) {
-        std::complex<float> acc(0.0f, 0.0f);
-        for (int n = 0; n < N; ++n) {
-            float ang = -twoPiOverN * float(k * n);
-            float cs = std::cos(ang);
-            float sn = std::sin(ang);
-            acc += std::complex<float>(cs, sn) * base[(size_t)n];
-        }
-        X[(size_t)k] = acc;
-    }
+    const RealFFT& fft = RealFFT::instance();
+    // One forward transform; every cutoff is an inverse of a tapered copy of it
+    Spectrum X;
+    fft.forward(base, X);
 
     std::vector<int> cuts = make_harmonic_cuts(bandsPerOctave);
     BLSet set;
@@ -55,49 +151,19 @@ BLSet build_bandlimited_set(const Table& base, int bandsPerOctave, bool normaliz
     set.tables.resize(cuts.size());
     set.baseRMS = compute_rms(base);
 
-    // For each cutoff, zero bins above cutoff while preserving conjugate symmetry
     for (size_t ci = 0; ci < cuts.size(); ++ci) {
-        int H = cuts[ci];
-        std::vector<std::complex<float>> Y = X; // copy
-        // bins: 0..N-1, positive freqs 1..N/2-1, Nyquist at N/2
-        int nyq = N / 2;
         // Apply soft taper near cutoff to reduce leakage/zipper in modulated cases
         const int taperBins = 6; // 4..8が目安
-        if (H < nyq) {
-            int startTaper = std::max(1, H - taperBins);
-            for (int k = 1; k <= nyq; ++k) {
-                if (k > H) {
-                    Y[(size_t)k] = std::complex<float>(0.0f, 0.0f);
-                    Y[(size_t)(N - k)] = std::complex<float>(0.0f, 0.0f);
-                } else if (k >= startTaper) {
-                    // raised-cosine from 1 -> 0 across [startTaper .. H]
-                    float t = float(k - startTaper) / float(std::max(1, H - startTaper));
-                    float w = 0.5f * (1.0f + std::cos(3.14159265358979323846f * t));
-                    Y[(size_t)k] *= w;
-                    Y[(size_t)(N - k)] *= w;
-                }
-            }
-        } else {
-            // H >= nyquist: keep all (no taper) to preserve maximum brightness
-        }
-        // Inverse DFT (naive)
-        Table t{};
-        for (int n = 0; n < N; ++n) {
-            std::complex<float> acc(0.0f, 0.0f);
-            for (int k = 0; k < N; ++k) {
-                float ang = twoPiOverN * float(k * n);
-                float cs = std::cos(ang);
-                float sn = std::sin(ang);
-                acc += std::complex<float>(cs, sn) * Y[(size_t)k];
-            }
-            // 1/N scaling for inverse DFT
-            acc /= float(N);
-            t[(size_t)n] = acc.real();
-        }
+        Spectrum Y = X;
+        apply_taper(Y, cuts[ci], taperBins);
+        Table& t = set.tables[ci];
+        fft.inverse(Y, t);
         // Normalize to match base RMS or clamp peak
         if (normalizeRMS) {
+            // Skip tables that are empty by construction (e.g. wav2-only at H=2): scaling
+            // them up would only amplify rounding noise
             float r = compute_rms(t);
-            if (r > 1e-12f) {
+            if (r > set.baseRMS * 1e-4f) {
                 float g = set.baseRMS / r;
                 for (float& v : t) v *= g;
             }
@@ -106,65 +172,25 @@ BLSet build_bandlimited_set(const Table& base, int bandsPerOctave, bool normaliz
             float m = 0.0f; for (float v : t) m = std::max(m, std::fabs(v));
             if (m > 1.0f) { for (float& v : t) v /= m; }
         }
-        set.tables[ci] = t;
     }
     return set;
 }
 
 Table apply_lowpass_with_taper(const Table& base, int H, int taperBins, bool normalizeRMS) {
-    const int N = (int)base.size();
-    int nyq = N / 2;
+    const int nyq = kHalf;
     if (H < 1) H = 1; if (H > nyq) H = nyq;
     if (taperBins < 0) taperBins = 0;
 
-    // DFT
-    std::vector<std::complex<float>> X(N);
-    const float twoPiOverN = 2.0f * 3.14159265358979323846f / (float)N;
-    for (int k = 0; k < N; ++k) {
-        std::complex<float> acc(0.0f, 0.0f);
-        for (int n = 0; n < N; ++n) {
-            float ang = -twoPiOverN * float(k * n);
-            float cs = std::cos(ang);
-            float sn = std::sin(ang);
-            acc += std::complex<float>(cs, sn) * base[(size_t)n];
-        }
-        X[(size_t)k] = acc;
-    }
-
-    // Low-pass with taper
-    std::vector<std::complex<float>> Y = X;
-    if (H < nyq) {
-        int startTaper = std::max(1, H - taperBins);
-        for (int k = 1; k <= nyq; ++k) {
-            if (k > H) {
-                Y[(size_t)k] = std::complex<float>(0.0f, 0.0f);
-                Y[(size_t)(N - k)] = std::complex<float>(0.0f, 0.0f);
-            } else if (k >= startTaper) {
-                float t = float(k - startTaper) / float(std::max(1, H - startTaper));
-                float w = 0.5f * (1.0f + std::cos(3.14159265358979323846f * t));
-                Y[(size_t)k] *= w;
-                Y[(size_t)(N - k)] *= w;
-            }
-        }
-    }
-
-    // IDFT
+    const RealFFT& fft = RealFFT::instance();
+    Spectrum Y;
+    fft.forward(base, Y);
+    apply_taper(Y, H, taperBins);
     Table t{};
-    for (int n = 0; n < N; ++n) {
-        std::complex<float> acc(0.0f, 0.0f);
-        for (int k = 0; k < N; ++k) {
-            float ang = twoPiOverN * float(k * n);
-            float cs = std::cos(ang);
-            float sn = std::sin(ang);
-            acc += std::complex<float>(cs, sn) * Y[(size_t)k];
-        }
-        acc /= float(N);
-        t[(size_t)n] = acc.real();
-    }
+    fft.inverse(Y, t);
     if (normalizeRMS) {
         float rBase = compute_rms(base);
         float r = compute_rms(t);
-        if (r > 1e-12f) {
+        if (r > rBase * 1e-4f) {
             float g = rBase / r;
             for (float& v : t) v *= g;
         }
@@ -0,0 +1,69 @@
+#include "dsp/decimator.h"
+#include <cmath>
+
+namespace msm5232 {
+
+namespace {
+
+// Hamming-windowed half-band lowpass (cutoff = quarter of the input rate) of length
+// 2*taps - 1, normalized to DC gain 1.0. Stores the non-zero non-centre taps
+// (even offsets k = 0, 2, ..., newest sample first) and returns the centre tap.
+struct HalfBandDesign {
+    alignas(32) float h[HalfBandStage::kMaxTaps]{};
+    float hc = 0.5f;
+    explicit HalfBandDesign(int taps) {
+        const int L = 4 * (taps / 2) - 1;
+        const int mid = (L - 1) / 2;
+        const double pi = 3.14159265358979323846;
+        double full[2 * HalfBandStage::kMaxTaps]{};
+        double sum = 0.0;
+        for (int k = 0; k < L; ++k) {
+            const int t = k - mid;
+            double w = 0.54 - 0.46 * std::cos(2.0 * pi * k / double(L - 1));
+            double s = (t == 0) ? 0.5 : std::sin(0.5 * pi * t) / (pi * t);
+            full[k] = w * s;
+            sum += full[k];
+        }
+        for (int j = 0; j < taps; ++j) h[j] = (float)(full[2 * j] / sum);
+        hc = (float)(full[mid] / sum);
+    }
+};
+
+const HalfBandDesign& design(int taps) {
+    static const HalfBandDesign shortHB(8);
+    static const HalfBandDesign longHB(16);
+    return taps == 16 ? longHB : shortHB;
+}
+
+}
+
+void HalfBandStage::configure(int n) {
+    const HalfBandDesign& d = design(n);
+    taps = (n == 16) ? 16 : 8;
+    h = d.h;
+    hc = d.hc;
+    // Centre of the 2*taps-1 filter is taps-1 samples back: older sample of the pair taps/2-1 pairs ago
+    centerDelay = taps / 2 - 1;
+    static_assert(kMaxTaps / 2 - 1 < kOlderHist, "older history must cover the centre tap");
+    reset();
+}
+
+void HalfBandStage::reset() {
+    newerHist.fill(0.0f);
+    olderHist.fill(0.0f);
+}
+
+void Decimator::configure(int newOS) {
+    if (newOS < 1) newOS = 1; if (newOS > kMaxOS) newOS = kMaxOS;
+    newOS = (newOS >= 8) ? 8 : (newOS >= 4) ? 4 : (newOS >= 2) ? 2 : 1;
+    if (newOS == os && (stages > 0 || os == 1)) return;
+    os = newOS;
+    stages = (os == 8) ? 3 : (os == 4) ? 2 : (os == 2) ? 1 : 0;
+    for (int s = 0; s < stages; ++s) st[(size_t)s].configure(s == stages - 1 ? 16 : 8);
+}
+
+void Decimator::reset() {
+    for (int s = 0; s < stages; ++s) st[(size_t)s].reset();
+}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace msm5232 {
+
+// One 2:1 half-band decimation stage in polyphase form. Every other tap of a
+// half-band filter is zero except the centre, so an output needs only the
+// non-zero taps on the newer sample of each input pair plus the centre tap on a
+// delayed older sample; outputs that would be discarded are never computed.
+// Blocks are processed a stage at a time: the input pairs are split into newer/older
+// lines behind the kept history, and the taps are applied across up to kChunk outputs
+// at once (fixed tap count, so the compiler unrolls the taps and vectorizes the outputs).
+struct HalfBandStage {
+    static constexpr int kMaxTaps = 16; // non-zero non-centre taps
+    static constexpr int kChunk = 64;   // outputs per pass
+    static constexpr int kOlderHist = 8;
+    const float* h = nullptr; // taps coefficients, newest sample first
+    float hc = 0.5f;          // centre tap
+    int taps = 0;
+    int centerDelay = 0;      // older-sample delay of the centre tap (in pairs)
+    // Last kMaxTaps - 1 newer and kOlderHist older samples, oldest first
+    std::array<float, kMaxTaps - 1> newerHist{};
+    std::array<float, kOlderHist> olderHist{};
+    // taps: 8 (short, 15-tap filter) or 16 (long, 31-tap filter)
+    void configure(int taps);
+    void reset();
+    // Consume n input samples (n even) and write n/2 outputs; in and out may alias
+    void process(const float* in, float* out, int n) {
+        if (taps == 16) processTaps<16>(in, out, n);
+        else processTaps<8>(in, out, n);
+    }
+
+private:
+    template <int kTaps>
+    void processTaps(const float* in, float* out, int n) {
+        constexpr int H = kMaxTaps - 1;
+        float newer[H + kChunk];
+        float older[kOlderHist + kChunk];
+        for (int m0 = 0; m0 < n / 2; m0 += kChunk) {
+            const int m = (n / 2 - m0 < kChunk) ? n / 2 - m0 : kChunk;
+            for (int i = 0; i < H; ++i) newer[i] = newerHist[(size_t)i];
+            for (int i = 0; i < kOlderHist; ++i) older[i] = olderHist[(size_t)i];
+            const float* src = in + 2 * m0;
+            for (int i = 0; i < m; ++i) {
+                older[kOlderHist + i] = src[2 * i];
+                newer[H + i] = src[2 * i + 1];
+            }
+            // Input is fully copied, so out may overwrite it. Each output sums its taps
+            // newest first, then adds the centre tap.
+            float* y = out + m0;
+            for (int i = 0; i < m; ++i) y[i] = h[0] * newer[H + i];
+            for (int j = 1; j < kTaps; ++j) {
+                const float hj = h[j];
+                const float* x = newer + H - j;
+                for (int i = 0; i < m; ++i) y[i] += hj * x[i];
+            }
+            const float* c = older + kOlderHist - centerDelay;
+            for (int i = 0; i < m; ++i) y[i] += hc * c[i];
+            for (int i = 0; i < H; ++i) newerHist[(size_t)i] = newer[m + i];
+            for (int i = 0; i < kOlderHist; ++i) olderHist[(size_t)i] = older[m + i];
+        }
+    }
+};
+
+// Oversampling decimator (per voice, or once for the shared HQ bus): a cascade of half-band stages (os = 2/4/8),
+// short filters at the higher rates and the long, steep filter for the last 2:1 step.
+struct Decimator {
+    static constexpr int kMaxOS = 8;
+    int os = 1;
+    int stages = 0;
+    std::array<HalfBandStage, 3> st{};
+    // os is clamped to 1/2/4/8; resets the state when the factor changes
+    void configure(int newOS);
+    void reset();
+    // in holds n * os subsamples (oldest first, overwritten); writes n outputs.
+    // One pass per stage over the whole block.
+    void process(float* in, float* out, int n) {
+        int m = n * os;
+        for (int s = 0; s < stages; ++s) {
+            st[(size_t)s].process(in, in, m);
+            m >>= 1;
+        }
+        for (int i = 0; i < n; ++i) out[i] = in[i];
+    }
+};
+
+}
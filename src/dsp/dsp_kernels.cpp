@@ -0,0 +1,152 @@
+#include "dsp/dsp_kernels_impl.h"
+#include "dsp/voice_bank.h"
+#include <cmath>
+#include <cstring>
+#if defined(MSM5232_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace msm5232 {
+namespace kernels {
+
+void render_bank_scalar(VoiceBank& b, int n) {
+    for (int l = 0; l < b.count; ++l) {
+        const float* tA = b.base + b.offA[l];
+        const float* tB = b.base + b.offB[l];
+        const int32_t mask = b.idxMask[l];
+        const uint32_t inc = b.inc[l];
+        const float wA = b.wA[l], wB = b.wB[l], vel = b.vel[l];
+        uint32_t phase = b.phase[l];
+        for (int i = 0; i < n; ++i) {
+            const int idx = (int)(phase >> kPhaseFracBits) & mask;
+            float s = tA[idx] * wA + tB[idx] * wB;
+            b.out[i][l] = (s * b.env[i][l]) * vel;
+            phase += inc; // wraps at the end of the cycle
+        }
+        b.phase[l] = phase;
+    }
+}
+
+// Output stage for one noise setting: the noise test is resolved at compile time
+template <bool kNoise>
+static void finish_scalar_t(const float* bus, float* outL, float* outR, int n, float gain, float d, float comp,
+                            uint32_t& rng) {
+    float noise[64];
+    for (int i0 = 0; i0 < n; i0 += 64) {
+        const int len = (n - i0 < 64) ? (n - i0) : 64;
+        if (kNoise) fill_noise(noise, len, rng);
+        for (int i = 0; i < len; ++i) {
+            float s = bus[i0 + i] * gain;
+            float y = s;
+            // Additive noise proportional to |s| ensures silence has no noise
+            if (kNoise) y = (s + d * std::fabs(s) * noise[i]) * comp;
+            outL[i0 + i] = y;
+            outR[i0 + i] = y;
+        }
+    }
+}
+
+void finish_scalar(const float* bus, float* outL, float* outR, int n, float gain, float d, float comp, uint32_t& rng) {
+    if (d > 0.0f) finish_scalar_t<true>(bus, outL, outR, n, gain, d, comp, rng);
+    else finish_scalar_t<false>(bus, outL, outR, n, gain, d, comp, rng);
+}
+
+} // namespace kernels
+
+namespace {
+
+#if defined(MSM5232_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+bool os_saves_ymm_zmm(bool zmm) {
+    int r[4];
+    __cpuid(r, 1);
+    if (!(r[2] & (1 << 27))) return false; // OSXSAVE
+    unsigned long long xcr0 = _xgetbv(0);
+    if ((xcr0 & 0x6) != 0x6) return false; // XMM + YMM state
+    if (zmm && (xcr0 & 0xE0) != 0xE0) return false; // opmask + ZMM state
+    return true;
+}
+#endif
+
+Isa detect_isa_x86() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 0);
+    const int maxLeaf = r[0];
+    __cpuid(r, 1);
+    const bool sse2 = (r[3] & (1 << 26)) != 0;
+    bool avx2 = false, avx512 = false;
+    if (maxLeaf >= 7) {
+        __cpuidex(r, 7, 0);
+        avx2 = (r[1] & (1 << 5)) != 0 && os_saves_ymm_zmm(false);
+        avx512 = (r[1] & (1 << 16)) != 0 && os_saves_ymm_zmm(true);
+    }
+#else
+    __builtin_cpu_init();
+    const bool sse2 = __builtin_cpu_supports("sse2");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+    const bool avx512 = __builtin_cpu_supports("avx512f");
+#endif
+    if (avx512 && avx2) return Isa::AVX512;
+    if (avx2) return Isa::AVX2;
+    if (sse2) return Isa::SSE2;
+    return Isa::Scalar;
+}
+#endif
+
+const DspKernels kScalar{Isa::Scalar, kernels::render_bank_scalar, kernels::finish_scalar};
+#if defined(MSM5232_X86)
+const DspKernels kSSE2{Isa::SSE2, kernels::render_bank_sse2, kernels::finish_sse2};
+const DspKernels kAVX2{Isa::AVX2, kernels::render_bank_avx2, kernels::finish_avx2};
+// 16-lane bank kernel; the output kernel is already memory bound at 8 lanes
+const DspKernels kAVX512{Isa::AVX512, kernels::render_bank_avx512, kernels::finish_avx2};
+#endif
+
+} // namespace
+
+Isa detect_isa() {
+#if defined(MSM5232_X86)
+    static const Isa best = detect_isa_x86();
+    return best;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+Isa resolve_isa(Isa requested) {
+    const Isa best = detect_isa();
+    if (requested == Isa::Auto) return best;
+    return (static_cast<int>(requested) > static_cast<int>(best)) ? best : requested;
+}
+
+const DspKernels& dsp_kernels(Isa isa) {
+    switch (resolve_isa(isa)) {
+#if defined(MSM5232_X86)
+        case Isa::AVX512: return kAVX512;
+        case Isa::AVX2: return kAVX2;
+        case Isa::SSE2: return kSSE2;
+#endif
+        default: return kScalar;
+    }
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Auto: return "auto";
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2: return "sse2";
+        case Isa::AVX2: return "avx2";
+        case Isa::AVX512: return "avx512";
+    }
+    return "?";
+}
+
+bool parse_isa(const char* name, Isa& out) {
+    static const Isa all[] = {Isa::Auto, Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512};
+    for (Isa isa : all) {
+        if (std::strcmp(name, isa_name(isa)) == 0) { out = isa; return true; }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+
+namespace msm5232 {
+
+struct VoiceBank;
+
+// Instruction sets with dedicated kernels. Auto picks the best one the CPU supports.
+enum class Isa : int { Auto = -1, Scalar = 0, SSE2 = 1, AVX2 = 2, AVX512 = 3 };
+
+// Vectorized hot loops, selected once per Synth::setup() by runtime CPU detection.
+// Every kernel set performs the same float operations in the same order, so output is
+// bit-identical whichever ISA is selected (the dsp library is built with FP contraction off).
+struct DspKernels {
+    Isa isa;
+    // VoiceBank lanes: advance phases, gather, crossfade, apply envelope/velocity
+    void (*renderBank)(VoiceBank& b, int n);
+    // Output stage: y = bus*gain, plus additive noise (s + d*|s|*noise)*comp when d > 0;
+    // rng is the xorshift32 state (noise stays sequential, so it matches across ISAs)
+    void (*finish)(const float* bus, float* outL, float* outR, int n, float gain, float d, float comp, uint32_t& rng);
+};
+
+// Best ISA supported by this CPU (and OS)
+Isa detect_isa();
+// Auto -> detect_isa(); otherwise the requested ISA, lowered to what the CPU supports
+Isa resolve_isa(Isa requested);
+// Kernel set for a resolved ISA
+const DspKernels& dsp_kernels(Isa isa);
+const char* isa_name(Isa isa);
+// "auto", "scalar", "sse2", "avx2", "avx512"; returns false for unknown names
+bool parse_isa(const char* name, Isa& out);
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+// Internal: per-ISA kernel entry points shared by dsp_kernels*.cpp
+#include "dsp/dsp_kernels.h"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MSM5232_X86 1
+#endif
+// Per-function ISA targeting (GCC/Clang); MSVC exposes all intrinsics without it
+#if defined(__GNUC__) || defined(__clang__)
+#define MSM5232_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MSM5232_TARGET(isa)
+#endif
+
+namespace msm5232 {
+namespace kernels {
+
+// xorshift32 noise in [-1, 1), sequential so every ISA sees the same values
+inline void fill_noise(float* out, int n, uint32_t& rng) {
+    uint32_t x = rng;
+    for (int i = 0; i < n; ++i) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        // Convert to float in [-1, 1]
+        float u01 = (float)(x) * 2.3283064365386963e-10f; // [0,1)
+        out[i] = u01 * 2.0f - 1.0f; // [-1,1)
+    }
+    rng = x;
+}
+
+void render_bank_scalar(VoiceBank& b, int n);
+void finish_scalar(const float* bus, float* outL, float* outR, int n, float gain, float d, float comp, uint32_t& rng);
+
+#if defined(MSM5232_X86)
+void render_bank_sse2(VoiceBank& b, int n);
+void finish_sse2(const float* bus, float* outL, float* outR, int n, float gain, float d, float comp, uint32_t& rng);
+void render_bank_avx2(VoiceBank& b, int n);
+void finish_avx2(const float* bus, float* outL, float* outR, int n, float gain, float d, float comp, uint32_t& rng);
+void render_bank_avx512(VoiceBank& b, int n);
+#endif
+
+}
+}
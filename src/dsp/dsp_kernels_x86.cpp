@@ -0,0 +1,175 @@
+#include "dsp/dsp_kernels_impl.h"
+#include "dsp/voice_bank.h"
+
+#if defined(MSM5232_X86)
+#include <cmath>
+#include <immintrin.h>
+
+namespace msm5232 {
+namespace kernels {
+
+// ---- SSE2 (4 lanes) ----
+
+// SSE2 has no gather: extract lane indices through registers (no store/reload stall)
+MSM5232_TARGET("sse2")
+static inline __m128 gather_sse2(const float* base, __m128i ix) {
+    float s0 = base[_mm_cvtsi128_si32(ix)];
+    float s1 = base[_mm_cvtsi128_si32(_mm_shuffle_epi32(ix, 1))];
+    float s2 = base[_mm_cvtsi128_si32(_mm_shuffle_epi32(ix, 2))];
+    float s3 = base[_mm_cvtsi128_si32(_mm_shuffle_epi32(ix, 3))];
+    return _mm_set_ps(s3, s2, s1, s0);
+}
+
+MSM5232_TARGET("sse2")
+void render_bank_sse2(VoiceBank& b, int n) {
+    for (int g = 0; g < b.count; g += 4) {
+        __m128i phase = _mm_load_si128(reinterpret_cast<const __m128i*>(b.phase + g));
+        const __m128i inc = _mm_load_si128(reinterpret_cast<const __m128i*>(b.inc + g));
+        const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(b.idxMask + g));
+        const __m128 wA = _mm_load_ps(b.wA + g);
+        const __m128 wB = _mm_load_ps(b.wB + g);
+        const __m128 vel = _mm_load_ps(b.vel + g);
+        const __m128i offA = _mm_load_si128(reinterpret_cast<const __m128i*>(b.offA + g));
+        const __m128i offB = _mm_load_si128(reinterpret_cast<const __m128i*>(b.offB + g));
+        for (int i = 0; i < n; ++i) {
+            // Fixed-point phase: index from the top bits, wrap by integer overflow
+            __m128i idx = _mm_and_si128(_mm_srli_epi32(phase, kPhaseFracBits), mask);
+            __m128 sa = gather_sse2(b.base, _mm_add_epi32(idx, offA));
+            __m128 sb = gather_sse2(b.base, _mm_add_epi32(idx, offB));
+            __m128 s = _mm_add_ps(_mm_mul_ps(sa, wA), _mm_mul_ps(sb, wB));
+            __m128 y = _mm_mul_ps(_mm_mul_ps(s, _mm_load_ps(b.env[i] + g)), vel);
+            _mm_store_ps(b.out[i] + g, y);
+            phase = _mm_add_epi32(phase, inc);
+        }
+        _mm_store_si128(reinterpret_cast<__m128i*>(b.phase + g), phase);
+    }
+}
+
+template <bool kNoise>
+MSM5232_TARGET("sse2")
+static void finish_sse2_t(const float* bus, float* outL, float* outR, int n, float gain, float d, float comp,
+                          uint32_t& rng) {
+    alignas(16) float noise[64];
+    const __m128 vg = _mm_set1_ps(gain), vd = _mm_set1_ps(d), vc = _mm_set1_ps(comp);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (int i0 = 0; i0 < n; i0 += 64) {
+        const int len = (n - i0 < 64) ? (n - i0) : 64;
+        if (kNoise) fill_noise(noise, len, rng);
+        int i = 0;
+        for (; i + 4 <= len; i += 4) {
+            __m128 s = _mm_mul_ps(_mm_loadu_ps(bus + i0 + i), vg);
+            __m128 y = s;
+            if (kNoise) {
+                __m128 a = _mm_mul_ps(_mm_mul_ps(vd, _mm_and_ps(s, absMask)), _mm_load_ps(noise + i));
+                y = _mm_mul_ps(_mm_add_ps(s, a), vc);
+            }
+            _mm_storeu_ps(outL + i0 + i, y);
+            _mm_storeu_ps(outR + i0 + i, y);
+        }
+        for (; i < len; ++i) {
+            float s = bus[i0 + i] * gain;
+            float y = s;
+            if (kNoise) y = (s + d * std::fabs(s) * noise[i]) * comp;
+            outL[i0 + i] = y;
+            outR[i0 + i] = y;
+        }
+    }
+}
+
+MSM5232_TARGET("sse2")
+void finish_sse2(const float* bus, float* outL, float* outR, int n, float gain, float d, float comp, uint32_t& rng) {
+    if (d > 0.0f) finish_sse2_t<true>(bus, outL, outR, n, gain, d, comp, rng);
+    else finish_sse2_t<false>(bus, outL, outR, n, gain, d, comp, rng);
+}
+
+// ---- AVX2 (8 lanes, hardware gather) ----
+
+MSM5232_TARGET("avx2")
+void render_bank_avx2(VoiceBank& b, int n) {
+    for (int g = 0; g < b.count; g += 8) {
+        __m256i phase = _mm256_load_si256(reinterpret_cast<const __m256i*>(b.phase + g));
+        const __m256i inc = _mm256_load_si256(reinterpret_cast<const __m256i*>(b.inc + g));
+        const __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(b.idxMask + g));
+        const __m256 wA = _mm256_load_ps(b.wA + g);
+        const __m256 wB = _mm256_load_ps(b.wB + g);
+        const __m256 vel = _mm256_load_ps(b.vel + g);
+        const __m256i offA = _mm256_load_si256(reinterpret_cast<const __m256i*>(b.offA + g));
+        const __m256i offB = _mm256_load_si256(reinterpret_cast<const __m256i*>(b.offB + g));
+        for (int i = 0; i < n; ++i) {
+            __m256i idx = _mm256_and_si256(_mm256_srli_epi32(phase, kPhaseFracBits), mask);
+            __m256 sa = _mm256_i32gather_ps(b.base, _mm256_add_epi32(idx, offA), 4);
+            __m256 sb = _mm256_i32gather_ps(b.base, _mm256_add_epi32(idx, offB), 4);
+            __m256 s = _mm256_add_ps(_mm256_mul_ps(sa, wA), _mm256_mul_ps(sb, wB));
+            __m256 y = _mm256_mul_ps(_mm256_mul_ps(s, _mm256_load_ps(b.env[i] + g)), vel);
+            _mm256_store_ps(b.out[i] + g, y);
+            phase = _mm256_add_epi32(phase, inc);
+        }
+        _mm256_store_si256(reinterpret_cast<__m256i*>(b.phase + g), phase);
+    }
+}
+
+template <bool kNoise>
+MSM5232_TARGET("avx2")
+static void finish_avx2_t(const float* bus, float* outL, float* outR, int n, float gain, float d, float comp,
+                          uint32_t& rng) {
+    alignas(32) float noise[64];
+    const __m256 vg = _mm256_set1_ps(gain), vd = _mm256_set1_ps(d), vc = _mm256_set1_ps(comp);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    for (int i0 = 0; i0 < n; i0 += 64) {
+        const int len = (n - i0 < 64) ? (n - i0) : 64;
+        if (kNoise) fill_noise(noise, len, rng);
+        int i = 0;
+        for (; i + 8 <= len; i += 8) {
+            __m256 s = _mm256_mul_ps(_mm256_loadu_ps(bus + i0 + i), vg);
+            __m256 y = s;
+            if (kNoise) {
+                __m256 a = _mm256_mul_ps(_mm256_mul_ps(vd, _mm256_and_ps(s, absMask)), _mm256_load_ps(noise + i));
+                y = _mm256_mul_ps(_mm256_add_ps(s, a), vc);
+            }
+            _mm256_storeu_ps(outL + i0 + i, y);
+            _mm256_storeu_ps(outR + i0 + i, y);
+        }
+        for (; i < len; ++i) {
+            float s = bus[i0 + i] * gain;
+            float y = s;
+            if (kNoise) y = (s + d * std::fabs(s) * noise[i]) * comp;
+            outL[i0 + i] = y;
+            outR[i0 + i] = y;
+        }
+    }
+}
+
+MSM5232_TARGET("avx2")
+void finish_avx2(const float* bus, float* outL, float* outR, int n, float gain, float d, float comp, uint32_t& rng) {
+    if (d > 0.0f) finish_avx2_t<true>(bus, outL, outR, n, gain, d, comp, rng);
+    else finish_avx2_t<false>(bus, outL, outR, n, gain, d, comp, rng);
+}
+
+// ---- AVX-512 (16 lanes) ----
+
+MSM5232_TARGET("avx512f")
+void render_bank_avx512(VoiceBank& b, int n) {
+    __m512i phase = _mm512_load_si512(b.phase);
+    const __m512i inc = _mm512_load_si512(b.inc);
+    const __m512i mask = _mm512_load_si512(b.idxMask);
+    const __m512 wA = _mm512_load_ps(b.wA);
+    const __m512 wB = _mm512_load_ps(b.wB);
+    const __m512 vel = _mm512_load_ps(b.vel);
+    const __m512i offA = _mm512_load_si512(b.offA);
+    const __m512i offB = _mm512_load_si512(b.offB);
+    for (int i = 0; i < n; ++i) {
+        __m512i idx = _mm512_and_si512(_mm512_srli_epi32(phase, kPhaseFracBits), mask);
+        __m512 sa = _mm512_i32gather_ps(_mm512_add_epi32(idx, offA), b.base, 4);
+        __m512 sb = _mm512_i32gather_ps(_mm512_add_epi32(idx, offB), b.base, 4);
+        __m512 s = _mm512_add_ps(_mm512_mul_ps(sa, wA), _mm512_mul_ps(sb, wB));
+        __m512 y = _mm512_mul_ps(_mm512_mul_ps(s, _mm512_load_ps(b.env[i])), vel);
+        _mm512_store_ps(b.out[i], y);
+        phase = _mm512_add_epi32(phase, inc);
+    }
+    _mm512_store_si512(b.phase, phase);
+}
+
+}
+}
+
+#endif // MSM5232_X86
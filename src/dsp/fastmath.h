@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+namespace msm5232 {
+
+// Approximations for the control-rate math (vibrato LFO, note frequency).
+// Error bounds below hold over the stated domains in single precision; msm5232_bench
+// --filter=fastmath checks them (non-zero exit on a violation) and times the std:: versions.
+
+// Selects std:: (Precise) or fastmath (Fast) where Synth has a choice
+enum class MathQuality : int { Precise = 0, Fast = 1 };
+
+namespace fastmath {
+
+constexpr float kPi = 3.14159265358979323846f;
+
+// sin(x) for |x| <= 64: reduction by pi (two-part constant), odd polynomial of degree 11
+// on [-pi/2, pi/2]. Max abs error 1.7e-7 over the domain. No library calls, constexpr.
+constexpr float sin(float x) {
+    // Branch-free (selects only), so loops over it vectorize
+    const float q = x * (1.0f / kPi);
+    const int k = (int)(q + (q >= 0.0f ? 0.5f : -0.5f)); // nearest multiple of pi
+    const float r = (x - (float)k * 3.140625f) - (float)k * 9.67653589793e-4f;
+    const float r2 = r * r;
+    float p = -2.5052108e-8f;
+    p = p * r2 + 2.7557319e-6f;
+    p = p * r2 - 1.9841270e-4f;
+    p = p * r2 + 8.3333333e-3f;
+    p = p * r2 - 1.6666667e-1f;
+    const float s = r + r * r2 * p;
+    return s * (float)(1 - 2 * (k & 1)); // odd multiples of pi flip the sign
+}
+
+// 2^x for x in [-126, 126] (clamped): nearest integer into the exponent bits, degree-6
+// polynomial for the fraction in [-0.5, 0.5]. Max relative error 2.5e-7 (4e-4 cents).
+// Not used by Synth: glibc's exp2f is faster, so the pitch ratio calls std::exp2. Kept
+// (and benchmarked) for libms where it is not.
+inline float exp2(float x) {
+    x = x < -126.0f ? -126.0f : x;
+    x = x > 126.0f ? 126.0f : x;
+    const int i = (int)(x + (x >= 0.0f ? 0.5f : -0.5f));
+    const float f = x - (float)i;
+    float p = 1.5403530e-4f;
+    p = p * f + 1.3333558e-3f;
+    p = p * f + 9.6181291e-3f;
+    p = p * f + 5.5504109e-2f;
+    p = p * f + 2.4022651e-1f;
+    p = p * f + 6.9314718e-1f;
+    p = p * f + 1.0f;
+    const uint32_t bits = (uint32_t)(i + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+// Equal-tempered frequency of a MIDI note (A4 = 69 = 440 Hz) from a 12-entry semitone
+// table and an exact octave scale: the correctly rounded 440 * 2^((note - 69) / 12) for
+// every note 0..127 (double internally). constexpr.
+constexpr float midi_to_freq(int note) {
+    constexpr double kSemitone[12] = {
+        1.0, 1.0594630943592953, 1.122462048309373, 1.189207115002721,
+        1.2599210498948732, 1.3348398541700344, 1.4142135623730951, 1.4983070768766815,
+        1.5874010519681994, 1.681792830507429, 1.7817974362806785, 1.8877486253633868,
+    };
+    const int d = note - 69;
+    int oct = d >= 0 ? d / 12 : -((11 - d) / 12);
+    double f = 440.0 * kSemitone[d - oct * 12];
+    for (; oct > 0; --oct) f *= 2.0;
+    for (; oct < 0; ++oct) f *= 0.5;
+    return (float)f;
+}
+
+}
+}
@@ -1,6 +1,5 @@
 #pragma once
 #include <array>
-#include <vector>
 
 namespace msm5232 {
 
@@ -8,21 +7,15 @@ namespace msm5232 {
 constexpr int kTableSize = 512;
 using Table = std::array<float, kTableSize>;
 
+// Base tables for every tone, quantize option and grid. The data is generated at compile
+// time into read-only storage; Tables is a stateless view of it, so any instance will do.
 struct Tables {
-    Tables();
     const Table& get(int mask /*1..15*/, bool quantized4, int effectiveLen) const; // wav1|wav2|wav4|wav8
     int baseLen() const { return kTableSize; }
-private:
     // Three grid variants:
     // -off375:   x starts at -0.375;   64-grid  (half-cycle dx=0.25)
     // -off4375:  x starts at -0.4375;  128-grid (half-cycle dx=0.125)
     // -off46875: x starts at -0.46875; 256-grid (half-cycle dx=0.0625)
-    std::array<Table, 16> tables_unquant_off375_{};  // index by mask 0..15 (0 unused)
-    std::array<Table, 16> tables_quant4_off375_{};   // 4-bit quantized
-    std::array<Table, 16> tables_unquant_off4375_{}; // index by mask 0..15 (0 unused)
-    std::array<Table, 16> tables_quant4_off4375_{};  // 4-bit quantized
-    std::array<Table, 16> tables_unquant_off46875_{}; // index by mask 0..15 (0 unused)
-    std::array<Table, 16> tables_quant4_off46875_{};  // 4-bit quantized
 };
 
 // Utility to compute a single table for a given mask
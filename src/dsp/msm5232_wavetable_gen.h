@@ -0,0 +1,136 @@
+#pragma once
+// Internal: constexpr wavetable generator. Only msm5232_wavetable.cpp includes this;
+// it evaluates the generator at compile time into read-only data. Each grid variant
+// needs a few million constexpr steps; src/CMakeLists.txt raises the MSVC/Clang limits.
+#include "dsp/msm5232_wavetable.h"
+#include <array>
+#include <cstddef>
+
+namespace msm5232 {
+namespace wavegen {
+
+// exp() in double precision, rounded to float (std::exp is not constexpr in C++17):
+// range reduction by ln 2 and a Taylor series, |x| well inside the float range
+constexpr float exp_f(float xf) {
+    const double x = xf;
+    constexpr double kLn2Hi = 6.93147180369123816490e-01;
+    constexpr double kLn2Lo = 1.90821492927058770002e-10;
+    constexpr double kInvLn2 = 1.44269504088896338700e+00;
+    const double kd = x * kInvLn2;
+    const int k = (int)(kd >= 0.0 ? kd + 0.5 : kd - 0.5);
+    const double r = (x - k * kLn2Hi) - k * kLn2Lo; // |r| <= ln2 / 2
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n <= 16; ++n) {
+        term *= r / n;
+        sum += term;
+    }
+    for (int i = 0; i < k; ++i) sum *= 2.0;
+    for (int i = 0; i > k; --i) sum *= 0.5;
+    return (float)sum;
+}
+
+// std::round (halfway cases away from zero)
+constexpr float round_f(float x) {
+    const float t = (float)(long)x; // truncated; exact for |x| < 2^31
+    const float d = x - t;
+    if (d >= 0.5f) return t + 1.0f;
+    if (d <= -0.5f) return t - 1.0f;
+    return t;
+}
+
+constexpr float abs_f(float x) { return x < 0.0f ? -x : x; }
+
+// Tanh-shaped step curve sampled at fractional x; norm = tanh_norm()
+constexpr float tanh_shape(float x /* nominally around 0..15 */, float norm) {
+    const float a = 3.0f;
+    const float b = 6.4f / 15.0f;
+    const float e = exp_f(a - b * x);
+    const float num = (e - 1.0f);
+    const float den = (e + 1.0f);
+    return ((num / den) / norm + 1.0f) * 100.0f;
+}
+
+constexpr float tanh_norm() {
+    const float a = 3.0f;
+    return (exp_f(a) - 1.0f) / (exp_f(a) + 1.0f);
+}
+
+constexpr int bit(int mask, int n) { return (mask & (1 << n)) ? 1 : 0; }
+
+// See makeTable_with_offset()
+constexpr Table make_table(int mask, bool quantize4, float x_offset, int group) {
+    Table y{};
+    constexpr int N = kTableSize; // 512
+    const int half = N / 2;           // 256 (wav1 segment)
+    const int quarter = N / 4;        // 128 (wav2 segment)
+    const int eighth = N / 8;         // 64  (wav4 segment)
+    const int sixteenth = N / 16;     // 32  (wav8 segment)
+
+    // x-step per sample over a half-cycle with grouping.
+    // With half=256, dx_step = (16*group)/256 = group/16 => 0.0625 (g=1), 0.125 (g=2), 0.25 (g=4)
+    const float dx_step = (16.0f * float(group)) / float(half);
+    // Every segment samples the curve at the same x positions: evaluate them once
+    std::array<float, kTableSize / 2> shape{};
+    const float norm = tanh_norm();
+    for (int j = 0; j * group < half; ++j) shape[(size_t)j] = tanh_shape(x_offset + dx_step * float(j), norm);
+
+    for (int k = 0; k < N; ++k) {
+        float v = 0.0f;
+
+        // wav1: 16 steps across half period, sign flip between halves
+        if (bit(mask, 0)) {
+            int posInHalf = k % half;
+            // Grouping duplicates same x across consecutive samples (64:2 samples, 128:1)
+            int sign = (k < half) ? +1 : -1;
+            v += sign * shape[(size_t)(posInHalf / group)] * 1.0f;
+        }
+        // wav2: 8 steps across each quarter, sign flips every quarter: - + - +
+        if (bit(mask, 1)) {
+            int posInQuarter = k % quarter;
+            int qBlock = (k / quarter) % 2; // 0,1,0,1...
+            int sign = (qBlock == 0) ? -1 : +1; // start negative
+            v += sign * shape[(size_t)(posInQuarter / group)] * 0.6f;
+        }
+        // wav4: 4 steps across each eighth, sign flips every eighth: - + - + ...
+        if (bit(mask, 2)) {
+            int posInEighth = k % eighth;
+            int eBlock = (k / eighth) % 2;
+            int sign = (eBlock == 0) ? -1 : +1;
+            v += sign * shape[(size_t)(posInEighth / group)] * 0.5f;
+        }
+        // wav8: 2 steps across each sixteenth, sign flips every sixteenth: - + - + ...
+        if (bit(mask, 3)) {
+            int posInSixteenth = k % sixteenth;
+            int sBlock = (k / sixteenth) % 2;
+            int sign = (sBlock == 0) ? -1 : +1;
+            v += sign * shape[(size_t)(posInSixteenth / group)] * 0.45f;
+        }
+        y[(size_t)k] = v;
+    }
+
+    // Normalize to [-1,1]
+    float maxAbs = 0.0f;
+    for (int k = 0; k < N; ++k) maxAbs = abs_f(y[(size_t)k]) > maxAbs ? abs_f(y[(size_t)k]) : maxAbs;
+    if (maxAbs > 0.0f) {
+        for (int k = 0; k < N; ++k) y[(size_t)k] = y[(size_t)k] / maxAbs;
+    }
+    // Optional 4-bit quantization (symmetric, -7..7 mapped to [-1,1])
+    if (quantize4) {
+        for (int k = 0; k < N; ++k) {
+            float q = round_f(y[(size_t)k] * 7.0f) / 7.0f;
+            if (q > 1.0f) q = 1.0f; if (q < -1.0f) q = -1.0f;
+            y[(size_t)k] = q;
+        }
+    }
+    return y;
+}
+
+// All 15 tones of one grid variant, indexed by mask (0 unused)
+constexpr std::array<Table, 16> make_set(bool quantize4, float x_offset, int group) {
+    std::array<Table, 16> s{};
+    for (int m = 1; m <= 15; ++m) s[(size_t)m] = make_table(m, quantize4, x_offset, group);
+    return s;
+}
+
+}
+}
@@ -0,0 +1,156 @@
+#include "dsp/rt_check.h"
+
+#if MSM5232_RT_CHECK
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace msm5232 {
+namespace rtcheck {
+
+namespace {
+// Name of the innermost active scope on this thread (nullptr: not the audio thread)
+thread_local const char* t_where = nullptr;
+
+void violation(const char* what) {
+    const char* where = t_where;
+    t_where = nullptr; // reporting must not recurse
+    // stdio on stderr is unbuffered, so this does not allocate
+    std::fprintf(stderr, "msm5232 rt-check: %s inside %s\n", what, where);
+    std::abort();
+}
+}
+
+Scope::Scope(const char* where) : prev_(t_where) {
+    if (where) t_where = where;
+}
+
+Scope::~Scope() { t_where = prev_; }
+
+void onLock(const char* what) {
+    if (t_where) violation(what);
+}
+
+}
+}
+
+namespace {
+
+inline void check(const char* what) {
+    msm5232::rtcheck::onLock(what); // same reporting as a lock
+}
+
+// Over-aligned blocks: malloc'ed with room for the alignment and the original pointer,
+// so every variant can be released with free()
+void* aligned_malloc(std::size_t n, std::size_t align) {
+    void* raw = std::malloc(n + align + sizeof(void*));
+    if (!raw) return nullptr;
+    std::uintptr_t p = ((std::uintptr_t)raw + sizeof(void*) + align - 1) & ~(std::uintptr_t)(align - 1);
+    ((void**)p)[-1] = raw;
+    return (void*)p;
+}
+
+void aligned_free(void* p) {
+    if (p) std::free(((void**)p)[-1]);
+}
+
+}
+
+void* operator new(std::size_t n) {
+    check("operator new");
+    void* p = std::malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+    check("operator new");
+    return std::malloc(n ? n : 1);
+}
+void* operator new[](std::size_t n, const std::nothrow_t& t) noexcept { return operator new(n, t); }
+void operator delete(void* p) noexcept {
+    if (p) check("operator delete");
+    std::free(p);
+}
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+
+void* operator new(std::size_t n, std::align_val_t a) {
+    check("operator new");
+    void* p = aligned_malloc(n ? n : 1, (std::size_t)a);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t n, std::align_val_t a) { return operator new(n, a); }
+void* operator new(std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept {
+    check("operator new");
+    return aligned_malloc(n ? n : 1, (std::size_t)a);
+}
+void* operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t& t) noexcept {
+    return operator new(n, a, t);
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+    if (p) check("operator delete");
+    aligned_free(p);
+}
+void operator delete[](void* p, std::align_val_t a) noexcept { operator delete(p, a); }
+void operator delete(void* p, std::size_t, std::align_val_t a) noexcept { operator delete(p, a); }
+void operator delete[](void* p, std::size_t, std::align_val_t a) noexcept { operator delete(p, a); }
+void operator delete(void* p, std::align_val_t a, const std::nothrow_t&) noexcept { operator delete(p, a); }
+void operator delete[](void* p, std::align_val_t a, const std::nothrow_t&) noexcept { operator delete(p, a); }
+
+#if MSM5232_RT_CHECK_WRAP
+// Linked with --wrap=<fn> (see src/CMakeLists.txt): calls to fn resolve to __wrap_fn,
+// __real_fn is the C library's
+#include <pthread.h>
+
+extern "C" {
+void* __real_malloc(std::size_t n);
+void __real_free(void* p);
+void* __real_calloc(std::size_t n, std::size_t size);
+void* __real_realloc(void* p, std::size_t n);
+int __real_posix_memalign(void** p, std::size_t align, std::size_t n);
+void* __real_aligned_alloc(std::size_t align, std::size_t n);
+int __real_pthread_mutex_lock(pthread_mutex_t* m);
+int __real_pthread_mutex_trylock(pthread_mutex_t* m);
+
+void* __wrap_malloc(std::size_t n) {
+    check("malloc");
+    return __real_malloc(n);
+}
+void __wrap_free(void* p) {
+    if (p) check("free");
+    __real_free(p);
+}
+void* __wrap_calloc(std::size_t n, std::size_t size) {
+    check("calloc");
+    return __real_calloc(n, size);
+}
+void* __wrap_realloc(void* p, std::size_t n) {
+    check("realloc");
+    return __real_realloc(p, n);
+}
+int __wrap_posix_memalign(void** p, std::size_t align, std::size_t n) {
+    check("posix_memalign");
+    return __real_posix_memalign(p, align, n);
+}
+void* __wrap_aligned_alloc(std::size_t align, std::size_t n) {
+    check("aligned_alloc");
+    return __real_aligned_alloc(align, n);
+}
+int __wrap_pthread_mutex_lock(pthread_mutex_t* m) {
+    check("pthread_mutex_lock");
+    return __real_pthread_mutex_lock(m);
+}
+int __wrap_pthread_mutex_trylock(pthread_mutex_t* m) {
+    check("pthread_mutex_trylock");
+    return __real_pthread_mutex_trylock(m);
+}
+}
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+// Real-time safety instrumentation. Configure with -DMSM5232_RT_CHECK=ON to build
+// msm5232_dsp with MSM5232_RT_CHECK=1: code inside an active Scope (Synth::process(),
+// setParams(), noteOn/noteOff in realtime mode) must not allocate, free or take a lock.
+// Global operator new/delete are replaced; on ELF platforms malloc/free/calloc/realloc/
+// posix_memalign/aligned_alloc and pthread_mutex_lock/trylock are wrapped at link time
+// (--wrap), elsewhere only the library's lock sites (onLock()) are caught. A violation
+// prints where it happened and aborts. In normal builds everything here compiles to
+// nothing.
+
+#ifndef MSM5232_RT_CHECK
+#define MSM5232_RT_CHECK 0
+#endif
+
+namespace msm5232 {
+namespace rtcheck {
+
+constexpr bool kEnabled = MSM5232_RT_CHECK != 0;
+
+#if MSM5232_RT_CHECK
+// Marks the calling thread as the audio thread for its lifetime (nests).
+// where == nullptr makes the scope inactive (e.g. offline renders, which may block).
+class Scope {
+public:
+    explicit Scope(const char* where);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+private:
+    const char* prev_;
+};
+// Called before acquiring a mutex; what names the lock
+void onLock(const char* what);
+#else
+class Scope {
+public:
+    explicit Scope(const char*) {}
+};
+inline void onLock(const char*) {}
+#endif
+
+}
+}
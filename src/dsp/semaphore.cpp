@@ -0,0 +1,44 @@
+#include "dsp/semaphore.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <climits>
+#elif defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#else
+#include <cerrno>
+#include <semaphore.h>
+#endif
+
+namespace msm5232 {
+
+#if defined(_WIN32)
+Semaphore::Semaphore() : h_(CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr)) {}
+Semaphore::~Semaphore() { CloseHandle((HANDLE)h_); }
+void Semaphore::post() { ReleaseSemaphore((HANDLE)h_, 1, nullptr); }
+void Semaphore::wait() { WaitForSingleObject((HANDLE)h_, INFINITE); }
+#elif defined(__APPLE__)
+// Unnamed POSIX semaphores are not implemented on macOS
+Semaphore::Semaphore() : h_(dispatch_semaphore_create(0)) {}
+Semaphore::~Semaphore() { dispatch_release((dispatch_semaphore_t)h_); }
+void Semaphore::post() { dispatch_semaphore_signal((dispatch_semaphore_t)h_); }
+void Semaphore::wait() { dispatch_semaphore_wait((dispatch_semaphore_t)h_, DISPATCH_TIME_FOREVER); }
+#else
+Semaphore::Semaphore() : h_(new sem_t) { sem_init((sem_t*)h_, 0, 0); }
+Semaphore::~Semaphore() {
+    sem_destroy((sem_t*)h_);
+    delete (sem_t*)h_;
+}
+void Semaphore::post() { sem_post((sem_t*)h_); }
+void Semaphore::wait() {
+    while (sem_wait((sem_t*)h_) != 0 && errno == EINTR) {}
+}
+#endif
+
+}
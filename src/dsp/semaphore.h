@@ -0,0 +1,22 @@
+#pragma once
+
+namespace msm5232 {
+
+// Counting semaphore for waking a worker from the audio thread: post() takes no lock
+// and does not allocate (sem_post / dispatch_semaphore_signal / ReleaseSemaphore), so
+// it is safe in a real-time callback, and a post before wait() is never lost (unlike a
+// condition variable notified without its mutex).
+class Semaphore {
+public:
+    Semaphore();
+    ~Semaphore();
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+    void post();
+    // Blocks until a post() is available and consumes it
+    void wait();
+private:
+    void* h_ = nullptr; // platform handle
+};
+
+}
@@ -1,4 +1,5 @@
 #include "dsp/synth.h"
+#include "dsp/rt_check.h"
 #include <algorithm>
 #include <cmath>
 
@@ -8,178 +9,288 @@ constexpr float kTwoPi = 6.28318530717958647692f;
 
 namespace msm5232 {
 
-static inline float midi_to_freq_int(int note) {
-    return 440.0f * std::pow(2.0f, (note - 69) / 12.0f);
+TableSetKey Synth::tableKey() const {
+    TableSetKey k;
+    k.toneMask = params_.toneMask;
+    k.quantize4 = params_.quantize4;
+    k.tableLen = params_.tableLen;
+    k.blQuality = params_.blQuality;
+    k.preHighCutMode = params_.preHighCutMode;
+    // Only ByMaxNote depends on these; keep them neutral otherwise to avoid needless rebuilds
+    if (params_.preHighCutMode == 2) {
+        k.preHighCutMaxNote = params_.preHighCutMaxNote;
+        k.vibratoDepthSemis = vibratoDepthSemis_;
+        k.sampleRate = sr_;
+    }
+    return k;
+}
+
+void Synth::applyTableSet() {
+    const TableSet* ts = builder_->current();
+    for (auto& v : voices_) v.setTableLen(ts->key.tableLen);
 }
 
 void Synth::setup(float sampleRate) {
     sr_ = sampleRate > 1.0f ? sampleRate : 48000.0f;
-    current_ = &tables_.get(params_.toneMask, params_.quantize4, params_.tableLen);
-    effective_ = current_;
-    preCutValid_ = false;
-    blsetValid_ = false;
+    // (Re)size the voice pool here, never on the audio thread
+    if ((int)voices_.size() != voiceCount_) {
+        voices_.assign((size_t)voiceCount_, Voice{});
+        voiceMgr_.init(voiceCount_);
+        voiceMgr_.setLimit(params_.polyphony, [](int) {});
+    }
+    // Not on the audio thread: build synchronously so playback starts with valid tables
+    builder_->buildNow(tableKey());
+    // Offline Synths (batch jobs, renders) rebuild synchronously and need no worker
+    if (realtime_) builder_->start();
+    kernels_ = &dsp_kernels(resolve_isa(isaRequest_));
+    // Slice buffers for the whole pool, and the worker pool for offline renders
+    const int slices = (voiceCount_ + kSliceVoices - 1) / kSliceVoices;
+    busy_.assign((size_t)voiceCount_, 0);
+    sliceBus_.assign((size_t)slices * kRenderChunk, 0.0f);
+    sliceOsBus_.assign((size_t)slices * kRenderChunk * Decimator::kMaxOS, 0.0f);
+    sliceOsVoices_.assign((size_t)slices, 0);
+    // Realtime Synths render on the calling thread only: no idle workers
+    const int workers = realtime_ ? 1 : std::min(renderThreads_, slices);
+    if (workers <= 1) pool_.reset();
+    else if (!pool_ || pool_->workers() != workers) pool_ = std::make_unique<WorkerPool>(workers);
+    scratch_.resize((size_t)workers);
+    for (auto& w : scratch_) { w.bank.kernels = kernels_; w.osBank.kernels = kernels_; }
+    busDecim_.reset();
+    busDecimLive_ = false;
     for (auto& v : voices_) {
         v.setSampleRate(sr_);
-        v.setTable(effective_, params_.tableLen);
         v.setADSR(params_.adsr);
     }
+    applyTableSet();
     vibratoPhase_ = 0.0f;
     // Seed RNG in a simple reproducible way from sample rate
     rngState_ = static_cast<uint32_t>(sr_) ^ 0x9E3779B9u;
 }
 
 void Synth::setParams(const SynthParams& p) {
-    // Determine what actually changed to avoid expensive rebuilds
-    bool tableChanged = (p.toneMask != params_.toneMask) || (p.quantize4 != params_.quantize4) || (p.tableLen != params_.tableLen);
+    rtcheck::Scope rt(realtime_ ? "Synth::setParams" : nullptr);
     bool adsrChanged = (p.adsr.attack != params_.adsr.attack) || (p.adsr.decay != params_.adsr.decay) ||
                        (p.adsr.sustain != params_.adsr.sustain) || (p.adsr.release != params_.adsr.release);
-    bool blQualChanged = (p.blQuality != params_.blQuality);
-    bool preHCChanged = (p.preHighCutMode != params_.preHighCutMode) || (p.preHighCutMaxNote != params_.preHighCutMaxNote);
 
     params_ = p;
+    voiceMgr_.setLimit(params_.polyphony, [this](int i) { voices_[(size_t)i].noteOff(); });
 
-    if (tableChanged) {
-        current_ = &tables_.get(params_.toneMask, params_.quantize4, params_.tableLen);
-        preCutValid_ = false;
-    }
     if (adsrChanged) {
         for (auto& v : voices_) v.setADSR(params_.adsr);
     }
-    // Prepare effective base (with optional pre-highcut)
-    if (tableChanged || preHCChanged || !preCutValid_) {
-        int mode = params_.preHighCutMode;
-        if (mode == 0) {
-            effective_ = current_;
-            preCutValid_ = true;
-        } else if (mode == 1) {
-            // Fixed gentle cut at ~0.65 * Nyquist
-            int nyq = msm5232::kTableSize / 2;
-            int H = (int)std::round(0.65f * nyq);
-            preCutBase_ = apply_lowpass_with_taper(*current_, H, 12, true);
-            effective_ = &preCutBase_;
-            preCutValid_ = true;
-        } else { // 2 = ByMaxNote
-            int nyq = msm5232::kTableSize / 2;
-            float f0max = midi_to_freq_int(params_.preHighCutMaxNote);
-            float guard = std::exp2(vibratoDepthSemis_ * (1.0f/12.0f)) * 1.05f;
-            float allowedH = (f0max > 0.0f ? (sr_ * 0.5f) / (f0max * guard) : (float)nyq);
-            int H = (int)std::floor(std::max(1.0f, std::min((float)nyq, allowedH)));
-            // Use slightly wider taper when H is small
-            int taper = (H < 16) ? 8 : 12;
-            preCutBase_ = apply_lowpass_with_taper(*current_, H, taper, true);
-            effective_ = &preCutBase_;
-            preCutValid_ = true;
-        }
-        for (auto& v : voices_) v.setTable(effective_, params_.tableLen);
-    }
-    // Rebuild bandlimited set only if necessary and only when quality > 0 (based on effective base)
-    if (tableChanged || blQualChanged || preHCChanged || !blsetValid_) {
-        blsetValid_ = false;
-        if (params_.blQuality > 0) {
-            blset_ = build_bandlimited_set(*effective_, params_.blQuality, true);
-            blsetValid_ = true;
-        }
+    // Table-dependent state (pre-highcut base, bandlimited set) comes from the shared cache
+    // (pointer swap) or is rebuilt in the background; the current set keeps playing until
+    // process() picks up the new one.
+    if (realtime_) {
+        if (builder_->request(tableKey())) applyTableSet();
+    } else if (builder_->current() && builder_->current()->key != tableKey()) {
+        // Offline: build in place so renders are deterministic
+        builder_->buildNow(tableKey());
+        applyTableSet();
     }
 }
 
 void Synth::noteOn(int note, int vel) {
-    // find free voice within current polyphony or steal via round-robin
-    int limit = std::max(1, std::min(params_.polyphony, (int)voices_.size()));
-    int idx = -1;
-    for (int i = 0; i < limit; ++i) {
-        if (!voices_[i].active()) { idx = i; break; }
-    }
-    if (idx < 0) { idx = nextVoice_ % limit; nextVoice_ = (nextVoice_ + 1) % limit; }
-    voices_[idx].noteOn(note, vel);
+    rtcheck::Scope rt(realtime_ ? "Synth::noteOn" : nullptr);
+    // Free voice within current polyphony, else steal (oldest releasing, then oldest held)
+    int idx = voiceMgr_.allocate(note);
+    if (idx >= 0) voices_[(size_t)idx].noteOn(note, vel);
 }
 
 void Synth::noteOff(int note) {
-    for (auto& v : voices_) if (v.active() && v.note() == note) v.noteOff();
+    rtcheck::Scope rt(realtime_ ? "Synth::noteOff" : nullptr);
+    voiceMgr_.release(note, [this](int i) { voices_[(size_t)i].noteOff(); });
 }
 
-void Synth::process(float* outL, float* outR, int frames) {
+bool Synth::process(float* outL, float* outR, int frames) {
+    // Offline renders may block (worker pool, synchronous table builds)
+    rtcheck::Scope rt(realtime_ ? "Synth::process" : nullptr);
     float lfoInc = kTwoPi * (vibratoRateHz_ / (sr_ > 0.f ? sr_ : 48000.f));
     // Additive noise ratio d (0..100) relative to |signal|
     float d = (noiseAdd_ > 0.f ? noiseAdd_ : 0.f);
     // Compensation to avoid clipping at s + d*|s| (<= (1+d))
     float comp = (d > 0.f) ? (1.0f / (1.0f + d)) : 1.0f;
 
-    // Avoid doing heavy work in audio callback; BL tables are prepared in setParams
-    
-    const float nyquist = 0.5f * sr_;
-    for (int n = 0; n < frames; ++n) {
-        float lfo = std::sin(vibratoPhase_);
-        // Use exp2f for cheaper pow2
-        float semis = pitchBendSemis_ + detuneSemis_ + vibratoDepthSemis_ * lfo;
-        float pitchRatio = std::exp2(semis * (1.0f/12.0f));
-        float s = 0.0f;
-        if (params_.blQuality <= 0) {
-            for (auto& v : voices_) if (v.active()) s += v.render(pitchRatio);
-        } else {
-            // Compute a conservative guard factor from vibrato depth to keep sidebands under Nyquist
-            float guard = std::exp2(vibratoDepthSemis_ * (1.0f/12.0f)) * 1.05f; // +5% safety
-            for (auto& v : voices_) if (v.active()) {
-                // Choose tables for the current pitch
-                float f0 = v.baseFreq() * pitchRatio;
-                float ef0 = f0 * guard; // guarded frequency estimate
+    // Pick up a freshly built table set, if any (wait-free)
+    if (builder_->update()) applyTableSet();
+    const TableSet* ts = builder_->current();
+    if (!ts) { // setup() not called yet
+        std::fill(outL, outL + frames, 0.0f);
+        std::fill(outR, outR + frames, 0.0f);
+        return true;
+    }
+    // Idle: no voice sounding and no decimator tail. Noise is relative to |signal|, so
+    // the output is exactly zero; only the LFO phase is advanced to stay continuous.
+    if (voiceMgr_.idle() && !busDecimLive_) {
+        std::fill(outL, outL + frames, 0.0f);
+        std::fill(outR, outR + frames, 0.0f);
+        vibratoPhase_ = std::fmod(vibratoPhase_ + lfoInc * (float)frames, kTwoPi);
+        return true;
+    }
+    // Conservative guard factor from vibrato depth to keep sidebands under Nyquist
+    const bool fast = mathQuality_ == MathQuality::Fast;
+    const float guard = std::exp2(vibratoDepthSemis_ * (1.0f/12.0f)) * 1.05f; // +5% safety
+    // Forced HQ oversampling factor (Auto2x is decided per voice)
+    const int forcedOS = (params_.hqMode == 2) ? 2 : (params_.hqMode == 3) ? 4 : (params_.hqMode == 4) ? 8 : 1;
+    // Bus HQ path: every oversampled voice runs at the same rate (Auto2x engages 2x only)
+    const int busOS = (params_.hqPath != 1) ? 1 : (params_.hqMode == 1) ? 2 : forcedOS;
+    // Without vibrato the pitch ratio is the same for every sub-block
+    const bool staticPitch = vibratoDepthSemis_ == 0.0f;
+    const float staticSemis = pitchBendSemis_ + detuneSemis_;
+    const float staticRatio = staticPitch ? std::exp2(staticSemis * (1.0f/12.0f)) : 1.0f;
+    const SliceFn render = sliceRenderer(!ts->blset.tables.empty(), staticPitch);
+
+    // Busy voices in list order; slices of kSliceVoices of them are the unit of work
+    int busyCount = 0;
+    voiceMgr_.forEachBusy([&](int vi) { busy_[(size_t)busyCount++] = vi; });
+    const int slices = (busyCount + kSliceVoices - 1) / kSliceVoices;
+
+    std::array<float, kRenderChunk> bus;
+    alignas(32) std::array<float, kRenderChunk * Decimator::kMaxOS> osBus;
+    for (int f0 = 0; f0 < frames; f0 += kRenderChunk) {
+        const int len = std::min(kRenderChunk, frames - f0);
+        // Control-rate values, held for each sub-block of the chunk
+        std::array<float, kRenderChunk / kControlBlock> pitch;
+        for (int n0 = 0, b = 0; n0 < len; n0 += kControlBlock, ++b) {
+            if (staticPitch) {
+                pitch[(size_t)b] = staticRatio;
+            } else {
+                float lfo = fast ? fastmath::sin(vibratoPhase_) : std::sin(vibratoPhase_);
+                float semis = pitchBendSemis_ + detuneSemis_ + vibratoDepthSemis_ * lfo;
+                // std::exp2 in both modes: glibc's exp2f beats fastmath::exp2 (bench --filter=fastmath)
+                pitch[(size_t)b] = std::exp2(semis * (1.0f/12.0f));
+            }
+            vibratoPhase_ += lfoInc * (float)std::min(kControlBlock, len - n0);
+            while (vibratoPhase_ > kTwoPi) vibratoPhase_ -= kTwoPi;
+        }
+        const ChunkContext ctx{ ts, len, busyCount, busOS, guard, pitch.data() };
+        auto job = [&](int slice, int worker) { (this->*render)(ctx, slice, worker); };
+        if (pool_ && !realtime_) pool_->run(slices, job);
+        else for (int sl = 0; sl < slices; ++sl) job(sl, 0);
+
+        // Sum the slices in order, so the result does not depend on how they were scheduled
+        std::fill(bus.begin(), bus.begin() + len, 0.0f);
+        int osVoices = 0;
+        for (int sl = 0; sl < slices; ++sl) {
+            const float* sb = &sliceBus_[(size_t)sl * kRenderChunk];
+            for (int i = 0; i < len; ++i) bus[(size_t)i] += sb[i];
+            osVoices += sliceOsVoices_[(size_t)sl];
+        }
+        if (busOS > 1 && (osVoices > 0 || busDecimLive_)) {
+            const int m = len * busOS;
+            std::fill(osBus.begin(), osBus.begin() + m, 0.0f);
+            for (int sl = 0; sl < slices; ++sl) {
+                if (sliceOsVoices_[(size_t)sl] == 0) continue;
+                const float* so = &sliceOsBus_[(size_t)sl * kRenderChunk * Decimator::kMaxOS];
+                for (int i = 0; i < m; ++i) osBus[(size_t)i] += so[i];
+            }
+            // A silent chunk after the last HQ voice flushes the decimator tail
+            if (!busDecimLive_) busDecim_.reset();
+            busDecim_.configure(busOS);
+            std::array<float, kRenderChunk> dec;
+            busDecim_.process(osBus.data(), dec.data(), len);
+            for (int i = 0; i < len; ++i) bus[(size_t)i] += dec[(size_t)i];
+            busDecimLive_ = osVoices > 0;
+        }
+
+        kernels_->finish(bus.data(), outL + f0, outR + f0, len, params_.gain, d, comp, rngState_);
+    }
+    // Voices whose envelope ended in this block become free for the next note-on
+    voiceMgr_.reclaim([this](int i) { return voices_[(size_t)i].active(); });
+    return false;
+}
+
+template <int kOS, bool kBus>
+Synth::SliceFn Synth::blSliceRenderer(bool staticPitch) {
+    return staticPitch ? &Synth::renderSlice<true, kOS, kBus, true> : &Synth::renderSlice<true, kOS, kBus, false>;
+}
+
+Synth::SliceFn Synth::sliceRenderer(bool bandlimited, bool staticPitch) const {
+    // The base table path has no table choice and no HQ
+    if (!bandlimited) return &Synth::renderSlice<false, 1, false, false>;
+    const bool bus = params_.hqPath == 1;
+    switch (params_.hqMode) {
+        case 1: return bus ? blSliceRenderer<0, true>(staticPitch) : blSliceRenderer<0, false>(staticPitch);
+        case 2: return bus ? blSliceRenderer<2, true>(staticPitch) : blSliceRenderer<2, false>(staticPitch);
+        case 3: return bus ? blSliceRenderer<4, true>(staticPitch) : blSliceRenderer<4, false>(staticPitch);
+        case 4: return bus ? blSliceRenderer<8, true>(staticPitch) : blSliceRenderer<8, false>(staticPitch);
+        default: return blSliceRenderer<1, false>(staticPitch);
+    }
+}
+
+template <bool kBL, int kOS, bool kBus, bool kStaticPitch>
+void Synth::renderSlice(const ChunkContext& c, int slice, int worker) {
+    SliceScratch& w = scratch_[(size_t)worker];
+    float* sbus = &sliceBus_[(size_t)slice * kRenderChunk];
+    float* sos = &sliceOsBus_[(size_t)slice * kRenderChunk * Decimator::kMaxOS];
+    std::fill(sbus, sbus + c.len, 0.0f);
+    const int v0 = slice * kSliceVoices;
+    const int v1 = std::min(v0 + kSliceVoices, c.busyCount);
+    if (!kBL) {
+        // All voices read the effective base table
+        for (int n0 = 0, blk = 0; n0 < c.len; n0 += kControlBlock, ++blk) {
+            const int len = std::min(kControlBlock, c.len - n0);
+            w.bank.clear(c.ts->base.data());
+            for (int k = v0; k < v1; ++k) {
+                Voice& v = voices_[(size_t)busy_[(size_t)k]];
+                if (v.active()) w.bank.add(v, 0, 0, 0.0f, c.pitch[blk], len);
+            }
+            w.bank.render(sbus + n0, len);
+        }
+        sliceOsVoices_[(size_t)slice] = 0;
+        return;
+    }
+    const BLSet& blset = c.ts->blset;
+    // Table offsets are relative to the BLSet's contiguous storage
+    const float* blBase = blset.tables[0].data();
+    struct Choice { int ia, ib; float mix; int os; };
+    std::array<Choice, kSliceVoices> choice;
+    int osVoices = 0;
+    for (int n0 = 0, blk = 0; n0 < c.len; n0 += kControlBlock, ++blk) {
+        const int len = std::min(kControlBlock, c.len - n0);
+        const float pitchRatio = c.pitch[blk];
+        float* bus = sbus + n0;
+        // Choose tables for the current pitch (with static pitch, once per chunk)
+        if (!kStaticPitch || blk == 0) {
+            for (int k = v0; k < v1; ++k) {
+                const Voice& v = voices_[(size_t)busy_[(size_t)k]];
+                float ef0 = v.baseFreq() * pitchRatio * c.guard; // guarded frequency estimate
                 int ia=0, ib=0; float mix=0.0f;
-                choose_tables_for_freq(blset_, ef0, sr_, ia, ib, mix);
-                const Table* tA = (ia >= 0 ? &blset_.tables[(size_t)ia] : nullptr);
-                const Table* tB = (ib >= 0 ? &blset_.tables[(size_t)ib] : tA);
-                // HQ oversampling: auto (2x) when ef0 is high, or forced (2x/4x/8x)
-                int os = 1;
-                if (params_.hqMode == 2) os = 2;          // Force2x
-                else if (params_.hqMode == 3) os = 4;     // Force4x
-                else if (params_.hqMode == 4) os = 8;     // Force8x
-                else if (params_.hqMode == 1) {
+                choose_tables_for_freq(blset, ef0, sr_, ia, ib, mix);
+                int os = kOS;
+                if (kOS == 0) {
                     // Auto2x: 近傍のhcutが最上段に近い/境界に近い時に発火
-                    int last = (int)blset_.hcuts.size() - 1;
+                    int last = (int)blset.hcuts.size() - 1;
                     float hlimit = (sr_ * 0.5f) / std::max(ef0, 1e-6f);
-                    float hHi = (float)blset_.hcuts[ib];
+                    float hHi = (float)blset.hcuts[ib];
                     bool nearTop = (ib >= last - 1) || ((hlimit - hHi) < 4.0f);
-                    if (nearTop) os = 2;
-                }
-                if (os <= 1) {
-                    s += v.renderFromTwoTables(tA, tB, mix, pitchRatio);
-                } else {
-                    float e;
-                    if (!v.beginFrame(e)) continue;
-                    // Configure per-voice FIR decimator for this OS
-                    v.decim().configure(os);
-                    const float invOS = 1.0f / float(os);
-                    // Push OS subsamples into decimator delay line
-                    for (int k = 0; k < os; ++k) {
-                        float sk = v.sampleFromTwoTables(tA, tB, mix);
-                        v.decim().push(sk);
-                        v.advancePhaseScaled(pitchRatio, invOS);
-                    }
-                    float vlin = v.velocity();
-                    float ydec = v.decim().output();
-                    s += ydec * e * vlin;
+                    os = nearTop ? 2 : 1;
                 }
+                choice[(size_t)(k - v0)] = Choice{ ia, ib, mix, os };
             }
         }
-        s *= params_.gain;
-
-        float y = s;
-        if (d > 0.0f) {
-            // xorshift32
-            uint32_t x = rngState_;
-            x ^= x << 13;
-            x ^= x >> 17;
-            x ^= x << 5;
-            rngState_ = x;
-            // Convert to float in [-1, 1]
-            float u01 = (float)(x) * 2.3283064365386963e-10f; // [0,1)
-            float noise = u01 * 2.0f - 1.0f; // [-1,1)
-            // Additive noise proportional to |s| ensures silence has no noise
-            y = (s + d * std::fabs(s) * noise) * comp;
+        w.bank.clear(blBase);
+        w.osBank.clear(blBase);
+        for (int k = v0; k < v1; ++k) {
+            Voice& v = voices_[(size_t)busy_[(size_t)k]];
+            if (!v.active()) continue;
+            const Choice& ch = choice[(size_t)(k - v0)];
+            if (kOS == 1 || (kOS == 0 && ch.os == 1)) {
+                w.bank.add(v, ch.ia * kTableSize, ch.ib * kTableSize, ch.mix, pitchRatio, len);
+            } else if (kBus) {
+                // The slice's high-rate bus is cleared on first use in this chunk
+                if (osVoices++ == 0) std::fill(sos, sos + c.len * c.busOS, 0.0f);
+                w.osBank.addOversampled(v, ch.ia * kTableSize, ch.ib * kTableSize, ch.mix, pitchRatio, c.busOS, len);
+            } else {
+                constexpr int os = kOS == 0 ? 2 : kOS;
+                v.renderOversampled<os>(&blset.tables[(size_t)ch.ia], &blset.tables[(size_t)ch.ib], ch.mix,
+                                        pitchRatio, bus, len);
+            }
         }
-        outL[n] = y;
-        outR[n] = y;
-        vibratoPhase_ += lfoInc;
-        if (vibratoPhase_ > kTwoPi) vibratoPhase_ -= kTwoPi;
+        w.bank.render(bus, len);
+        if (kBus && w.osBank.count > 0) w.osBank.render(sos + n0 * c.busOS, len * c.busOS);
     }
+    sliceOsVoices_[(size_t)slice] = osVoices;
 }
 
 }
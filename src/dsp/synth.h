@@ -2,8 +2,16 @@
 #include "dsp/msm5232_wavetable.h"
 #include "dsp/voice.h"
 #include "dsp/bandlimited.h"
+#include "dsp/table_builder.h"
+#include "dsp/voice_bank.h"
+#include "dsp/voice_manager.h"
+#include "dsp/worker_pool.h"
+#include "dsp/fastmath.h"
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace msm5232 {
 
@@ -11,13 +19,16 @@ struct SynthParams {
     int toneMask = 1; // 1..15
     ADSRParams adsr{};
     float gain = 0.5f;
-    int polyphony = 32; // 1..32
+    int polyphony = 32; // 1..voice pool size (Synth::setVoiceCount)
     bool quantize4 = true;
     int tableLen = 128; // 64 or 128 effective length
     // Bandlimit quality: 0=off, 1..8 = bands per octave
     int blQuality = 0;
     // HQ Mode: 0=Off, 1=Auto2x (high f0/deep vib only), 2=Force2x, 3=Force4x, 4=Force8x
     int hqMode = 0;
+    // HQ path: 0=PerVoice (each oversampled voice has its own decimator),
+    // 1=Bus (oversampled voices are mixed at the high rate and decimated once)
+    int hqPath = 0;
     // Pre-HighCut mode: 0=Off, 1=Fixed, 2=ByMaxNote
     int preHighCutMode = 0;
     // When ByMaxNote: highest expected MIDI note (0..127). Default=64
@@ -26,13 +37,46 @@ struct SynthParams {
 
 class Synth {
 public:
+    // Control-rate sub-block: LFO, pitch ratio and table choice are computed once per
+    // kControlBlock samples, voices are rendered as tight loops over the sub-block.
+    static constexpr int kControlBlock = 16;
+    static constexpr int kMaxVoices = 256;
+    // process() renders in chunks of kRenderChunk frames. Busy voices are split into slices
+    // of kSliceVoices (one VoiceBank each) that render the whole chunk into their own
+    // partial buses; the partials are summed in slice order, so the output is the same
+    // whether the slices ran on one thread or on a worker pool.
+    static constexpr int kRenderChunk = 128;
+    static constexpr int kSliceVoices = VoiceBank::kLanes;
+    static_assert(kRenderChunk % kControlBlock == 0, "chunk must hold whole sub-blocks");
+    static_assert(kControlBlock * Decimator::kMaxOS <= VoiceBank::kMaxBlock, "sub-block exceeds VoiceBank capacity");
     void setup(float sampleRate);
     void setParams(const SynthParams& p);
+    // Realtime (default): table rebuilds run on a background thread and are swapped in
+    // when ready. Non-realtime: setParams() rebuilds synchronously (deterministic renders).
+    // Set before setup(), which starts the background builder only in realtime mode.
+    void setRealtime(bool rt) { realtime_ = rt; }
+    // SIMD kernel set (Auto = best the CPU supports); takes effect at the next setup()
+    void setIsa(Isa isa) { isaRequest_ = isa; }
+    Isa isa() const { return kernels_->isa; }
+    // Voice pool size (1..kMaxVoices, default 128); allocated at the next setup(), so
+    // polyphony can be raised up to it without touching memory on the audio thread
+    void setVoiceCount(int n) { voiceCount_ = std::max(1, std::min(kMaxVoices, n)); }
+    int voiceCount() const { return voiceCount_; }
+    // Worker threads (including the caller) for non-realtime renders (setRealtime(false));
+    // takes effect at the next setup(). Output does not depend on the count.
+    void setRenderThreads(int n) { renderThreads_ = std::max(1, n); }
+    // Vibrato LFO sine through fastmath (default) or std:: (reference renders); the pitch
+    // ratio always uses std::exp2
+    void setMathQuality(MathQuality q) { mathQuality_ = q; }
     void noteOn(int note, int vel);
     void noteOff(int note);
-    void process(float* outL, float* outR, int frames);
+    // Returns true when nothing was sounding: the outputs were zero-filled and all
+    // per-sample work (LFO, table reads, noise) was skipped
+    bool process(float* outL, float* outR, int frames);
     void setPitchBendSemis(float semis) { pitchBendSemis_ = semis; }
     void setDetuneSemis(float semis) { detuneSemis_ = semis; }
+    // Output gain only (no table-set lookup), for automation ramps
+    void setGain(float g) { params_.gain = g; }
     void setVibratoDepthSemis(float semis) { vibratoDepthSemis_ = semis; }
     void setVibratoRateHz(float hz) { vibratoRateHz_ = hz; }
     // amt: noise amplitude ratio relative to |signal|, allowed 0..100 (1:100)
@@ -40,18 +84,54 @@ public:
         if (amt < 0.f) amt = 0.f; if (amt > 100.f) amt = 100.f; noiseAdd_ = amt;
     }
 private:
+    struct ChunkContext {
+        const TableSet* ts;
+        int len;       // frames in the chunk
+        int busyCount; // entries of busy_
+        int busOS;
+        float guard;
+        const float* pitch; // pitch ratio per sub-block
+    };
+    // Per-worker VoiceBanks
+    struct SliceScratch {
+        VoiceBank bank;   // SoA lanes for the SIMD table-read kernel
+        VoiceBank osBank; // HQ bus path: lanes rendered at the oversampled rate
+    };
+    // Slice renderers specialized per configuration, picked once per process() call:
+    // kBL: bandlimited set (else the base table); kOS: HQ factor (1 = off, 2/4/8 forced,
+    // 0 = Auto2x decided per voice); kBus: HQ voices go to the shared bus (hqPath = Bus);
+    // kStaticPitch: no vibrato, so each voice's table choice holds for the whole chunk
+    template <bool kBL, int kOS, bool kBus, bool kStaticPitch>
+    void renderSlice(const ChunkContext& c, int slice, int worker);
+    using SliceFn = void (Synth::*)(const ChunkContext& c, int slice, int worker);
+    SliceFn sliceRenderer(bool bandlimited, bool staticPitch) const;
+    template <int kOS, bool kBus>
+    static SliceFn blSliceRenderer(bool staticPitch);
+    TableSetKey tableKey() const;
+    void applyTableSet();
     float sr_ = 48000.0f;
-    Tables tables_{};
-    const Table* current_ = nullptr;     // raw base from Tables
-    const Table* effective_ = nullptr;   // points to raw or preCutBase_
-    Table preCutBase_{};                 // if preHighCut=On
-    bool preCutValid_ = false;
-    // Bandlimited set for current table parameters (lazily built)
-    BLSet blset_{};
-    bool blsetValid_ = false;
-    std::array<Voice, 32> voices_{};
+    bool realtime_ = true;
+    // Effective base + bandlimited set, built off the audio thread and swapped in atomically
+    std::unique_ptr<TableBuilder> builder_ = std::make_unique<TableBuilder>();
+    // Voice pool, sized in setup(); per block only busy voices (voiceMgr_) are touched
+    int voiceCount_ = 128;
+    std::vector<Voice> voices_;
+    VoiceManager voiceMgr_{}; // free list, note -> voice chains, stealing order
+    // Slice rendering (sized in setup())
+    int renderThreads_ = 1;
+    std::unique_ptr<WorkerPool> pool_;
+    std::vector<SliceScratch> scratch_;  // one per worker
+    std::vector<int> busy_;              // busy voice indices for the current process() call
+    std::vector<float> sliceBus_;        // [slice][kRenderChunk]
+    std::vector<float> sliceOsBus_;      // [slice][kRenderChunk * Decimator::kMaxOS]
+    std::vector<int> sliceOsVoices_;     // HQ bus voices per slice (0: its high-rate bus is unused)
+    // HQ bus path: one shared decimator
+    Decimator busDecim_{};
+    bool busDecimLive_ = false; // decimator holds a tail from the previous sub-block
+    Isa isaRequest_ = Isa::Auto;
+    MathQuality mathQuality_ = MathQuality::Fast;
+    const DspKernels* kernels_ = &dsp_kernels(Isa::Scalar); // resolved in setup()
     SynthParams params_{};
-    int nextVoice_ = 0; // round-robin for stealing within polyphony
     float pitchBendSemis_ = 0.0f; // from MIDI PB
     float detuneSemis_ = 0.0f;    // from UI param
     float vibratoDepthSemis_ = 0.0f; // LFO depth in semis
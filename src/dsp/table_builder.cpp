@@ -0,0 +1,203 @@
+#include "dsp/table_builder.h"
+#include "dsp/fastmath.h"
+#include "dsp/rt_check.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace msm5232 {
+
+TableSet* build_table_set(const Tables& tables, const TableSetKey& key) {
+    auto* s = new TableSet();
+    s->key = key;
+    const Table& raw = tables.get(key.toneMask, key.quantize4, key.tableLen);
+    // Prepare effective base (with optional pre-highcut)
+    if (key.preHighCutMode == 0) {
+        s->base = raw;
+    } else if (key.preHighCutMode == 1) {
+        // Fixed gentle cut at ~0.65 * Nyquist
+        int nyq = msm5232::kTableSize / 2;
+        int H = (int)std::round(0.65f * nyq);
+        s->base = apply_lowpass_with_taper(raw, H, 12, true);
+    } else { // 2 = ByMaxNote
+        int nyq = msm5232::kTableSize / 2;
+        float f0max = fastmath::midi_to_freq(key.preHighCutMaxNote);
+        float guard = std::exp2(key.vibratoDepthSemis * (1.0f/12.0f)) * 1.05f;
+        float allowedH = (f0max > 0.0f ? (key.sampleRate * 0.5f) / (f0max * guard) : (float)nyq);
+        int H = (int)std::floor(std::max(1.0f, std::min((float)nyq, allowedH)));
+        // Use slightly wider taper when H is small
+        int taper = (H < 16) ? 8 : 12;
+        s->base = apply_lowpass_with_taper(raw, H, taper, true);
+    }
+    // Bandlimited set only when quality > 0 (based on effective base)
+    if (key.blQuality > 0) {
+        s->blset = build_bandlimited_set(s->base, key.blQuality, true);
+    }
+    return s;
+}
+
+std::shared_ptr<TableSetCache> TableSetCache::shared() {
+    static std::mutex m;
+    static std::weak_ptr<TableSetCache> store;
+    rtcheck::onLock("TableSetCache mutex");
+    std::lock_guard<std::mutex> lk(m);
+    std::shared_ptr<TableSetCache> c = store.lock();
+    if (!c) {
+        c = std::make_shared<TableSetCache>();
+        store = c;
+    }
+    return c;
+}
+
+TableSetCache::~TableSetCache() {
+    for (auto& slot : slots_) delete slot.exchange(nullptr);
+}
+
+int TableSetCache::slotIndex(const TableSetKey& key) {
+    int mask = std::max(1, std::min(15, key.toneMask)) - 1;
+    // Same grid selection as Tables::get()
+    int grid = (key.tableLen <= 64) ? 0 : (key.tableLen <= 128) ? 1 : 2;
+    int q = std::max(0, std::min(8, key.blQuality));
+    int idx = mask;
+    idx = idx * 2 + (key.quantize4 ? 1 : 0);
+    idx = idx * 3 + grid;
+    idx = idx * 9 + q;
+    idx = idx * 2 + (key.preHighCutMode == 1 ? 1 : 0);
+    return idx;
+}
+
+const TableSet* TableSetCache::find(const TableSetKey& key) const {
+    if (!cacheable(key)) return nullptr;
+    const TableSet* s = slots_[(size_t)slotIndex(key)].load(std::memory_order_acquire);
+    // Entries are shared by every tableLen that maps to the same grid; reject mismatches
+    return (s && s->key == key) ? s : nullptr;
+}
+
+const TableSet* TableSetCache::getOrBuild(const Tables& tables, const TableSetKey& key) {
+    if (!cacheable(key)) return nullptr;
+    auto& slot = slots_[(size_t)slotIndex(key)];
+    const TableSet* s = slot.load(std::memory_order_acquire);
+    if (s) return s->key == key ? s : nullptr;
+    TableSet* built = build_table_set(tables, key);
+    built->cached = true;
+    const TableSet* expected = nullptr;
+    if (!slot.compare_exchange_strong(expected, built, std::memory_order_acq_rel)) {
+        // Another builder won the race; its entry is equivalent
+        delete built;
+        return expected->key == key ? expected : nullptr;
+    }
+    return built;
+}
+
+TableBuilder::~TableBuilder() {
+    if (thread_.joinable()) {
+        running_.store(false);
+        wake_.post();
+        thread_.join();
+    }
+    auto release = [](const TableSet* s) { if (s && !s->cached) delete s; };
+    release(ready_.exchange(nullptr));
+    release(retired_.exchange(nullptr));
+    release(current_);
+}
+
+void TableBuilder::start() {
+    if (thread_.joinable()) return;
+    running_.store(true);
+    thread_ = std::thread([this] { run(); });
+}
+
+const TableSet* TableBuilder::obtain(const TableSetKey& key) {
+    if (const TableSet* c = cache_->getOrBuild(tables_, key)) return c;
+    return build_table_set(tables_, key);
+}
+
+bool TableBuilder::install(const TableSet* s) {
+    if (current_ && !current_->cached) {
+        // Owned sets are freed by the worker; wait until the hand-over slot is free
+        if (retired_.load(std::memory_order_acquire) != nullptr) return false;
+        retire(current_);
+    }
+    current_ = s;
+    return true;
+}
+
+void TableBuilder::retire(const TableSet* s) {
+    retired_.store(s, std::memory_order_release);
+    wake_.post();
+}
+
+void TableBuilder::buildNow(const TableSetKey& key) {
+    wanted_ = key;
+    hasWanted_ = true;
+    const TableSet* s = obtain(key);
+    if (current_ && !current_->cached) delete current_;
+    current_ = s;
+}
+
+bool TableBuilder::request(const TableSetKey& key) {
+    if (hasWanted_ && key == wanted_) return false;
+    wanted_ = key;
+    hasWanted_ = true;
+    // Fast path: already cached -> pointer swap, no worker round-trip
+    if (const TableSet* c = cache_->find(key)) {
+        if (install(c)) return true;
+    }
+    slots_[(size_t)writeIdx_] = key;
+    int prev = shared_.exchange(writeIdx_ | kDirty, std::memory_order_acq_rel);
+    writeIdx_ = prev & 3;
+    wake_.post();
+    return false;
+}
+
+bool TableBuilder::update() {
+    // Wait until the worker has reclaimed the previously replaced set
+    if (retired_.load(std::memory_order_acquire) != nullptr) return false;
+    const TableSet* s = ready_.exchange(nullptr, std::memory_order_acq_rel);
+    if (!s) return false;
+    if (s->key != wanted_ || s == current_) {
+        // Superseded while building (or already installed from the cache)
+        if (!s->cached) retire(s);
+        return false;
+    }
+    return install(s);
+}
+
+bool TableBuilder::takeRequest(TableSetKey& out) {
+    if (!(shared_.load(std::memory_order_acquire) & kDirty)) return false;
+    int prev = shared_.exchange(readIdx_, std::memory_order_acq_rel);
+    readIdx_ = prev & 3;
+    out = slots_[(size_t)readIdx_];
+    return true;
+}
+
+void TableBuilder::reclaim() {
+    const TableSet* s = retired_.exchange(nullptr, std::memory_order_acq_rel);
+    if (s && !s->cached) delete s;
+}
+
+void TableBuilder::run() {
+    while (running_.load()) {
+        // Sleep until posted, except while there are tones left to prefetch (posts made
+        // meanwhile stay counted, so nothing is missed)
+        if (prefetchNext_ > 15) wake_.wait();
+        reclaim();
+        TableSetKey key;
+        if (takeRequest(key)) {
+            const TableSet* s = obtain(key);
+            // A set the audio thread never picked up can be freed right away
+            const TableSet* stale = ready_.exchange(s, std::memory_order_acq_rel);
+            if (stale && !stale->cached) delete stale;
+            if (TableSetCache::cacheable(key)) { prefetchKey_ = key; prefetchNext_ = 1; }
+            continue;
+        }
+        // Idle: fill in the other tones so tone automation hits the cache
+        if (prefetchNext_ <= 15) {
+            TableSetKey k = prefetchKey_;
+            k.toneMask = prefetchNext_++;
+            cache_->getOrBuild(tables_, k);
+        }
+    }
+}
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "dsp/msm5232_wavetable.h"
+#include "dsp/bandlimited.h"
+#include "dsp/semaphore.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace msm5232 {
+
+// Parameters that determine the tables a Synth plays from.
+struct TableSetKey {
+    int toneMask = 1;
+    bool quantize4 = true;
+    int tableLen = 128;
+    int blQuality = 0;
+    int preHighCutMode = 0;
+    int preHighCutMaxNote = 64;
+    float vibratoDepthSemis = 0.0f; // only relevant for ByMaxNote
+    float sampleRate = 48000.0f;    // only relevant for ByMaxNote
+    bool operator==(const TableSetKey& o) const {
+        return toneMask == o.toneMask && quantize4 == o.quantize4 && tableLen == o.tableLen &&
+               blQuality == o.blQuality && preHighCutMode == o.preHighCutMode &&
+               preHighCutMaxNote == o.preHighCutMaxNote && vibratoDepthSemis == o.vibratoDepthSemis &&
+               sampleRate == o.sampleRate;
+    }
+    bool operator!=(const TableSetKey& o) const { return !(*this == o); }
+};
+
+// Immutable result of a build: effective base (raw or pre-cut) and its bandlimited set.
+struct TableSet {
+    TableSetKey key{};
+    Table base{};        // raw base from Tables or its pre-cut version
+    BLSet blset{};       // empty when blQuality == 0
+    bool cached = false; // owned by TableSetCache (never freed by a builder)
+};
+
+// Build a table set (allocates; never call from the audio thread).
+TableSet* build_table_set(const Tables& tables, const TableSetKey& key);
+
+// Process-wide cache of every table set that does not depend on the sample rate:
+// 15 tones x 2 quantize x 3 grids x 9 BL qualities (0..8) x PreHighCut Off/Fixed.
+// Entries are built lazily (on a builder thread) and never change once published,
+// so find() is a single atomic load and safe on the audio thread. The cache is shared
+// by all builders and freed with the last reference.
+class TableSetCache {
+public:
+    static std::shared_ptr<TableSetCache> shared();
+    TableSetCache() = default;
+    ~TableSetCache();
+    static bool cacheable(const TableSetKey& key) { return key.preHighCutMode != 2; }
+    // Wait-free lookup; nullptr when not built yet (or not cacheable)
+    const TableSet* find(const TableSetKey& key) const;
+    // Build the entry if missing (non-realtime)
+    const TableSet* getOrBuild(const Tables& tables, const TableSetKey& key);
+private:
+    static int slotIndex(const TableSetKey& key);
+    static constexpr int kSlots = 15 * 2 * 3 * 9 * 2;
+    std::array<std::atomic<const TableSet*>, kSlots> slots_{};
+};
+
+// Background builder that publishes TableSets to the audio thread.
+// - request()/update()/current() are wait-free and called from the audio thread only.
+// - Cached sets are installed directly by request(); anything else is built (and cached)
+//   by the worker, which then prefetches the other tones of the same configuration.
+// - The previous set keeps playing until the new one is ready; replaced sets are
+//   handed back to the worker and freed there (never on the audio thread).
+// - The worker sleeps until the audio thread posts work (no polling). Only realtime
+//   Synths start it; offline ones build synchronously with buildNow().
+class TableBuilder {
+public:
+    TableBuilder() = default;
+    ~TableBuilder();
+    TableBuilder(const TableBuilder&) = delete;
+    TableBuilder& operator=(const TableBuilder&) = delete;
+
+    // Start the worker thread (idempotent; non-realtime). Without it only cached sets and
+    // buildNow() can change current().
+    void start();
+    // Build synchronously and install as current (non-realtime, e.g. from setup()).
+    void buildNow(const TableSetKey& key);
+    // Post the latest wanted key; older pending requests are superseded.
+    // Returns true when a cached set was installed immediately (current() changed).
+    bool request(const TableSetKey& key);
+    // Swap in a newly built set if one matching the latest request is ready.
+    // Returns true when current() changed.
+    bool update();
+    const TableSet* current() const { return current_; }
+    const TableSetKey& wanted() const { return wanted_; }
+
+private:
+    void run();
+    bool takeRequest(TableSetKey& out);
+    void reclaim();
+    const TableSet* obtain(const TableSetKey& key);
+    bool install(const TableSet* s);
+    void retire(const TableSet* s);
+
+    Tables tables_{};
+    std::shared_ptr<TableSetCache> cache_ = TableSetCache::shared();
+    // Audio-thread owned
+    const TableSet* current_ = nullptr;
+    TableSetKey wanted_{};
+    bool hasWanted_ = false;
+    // Latest-value mailbox (triple buffer): audio thread writes, worker reads
+    static constexpr int kDirty = 4;
+    std::array<TableSetKey, 3> slots_{};
+    std::atomic<int> shared_{2};
+    int writeIdx_ = 0;
+    int readIdx_ = 1;
+    // Hand-over slots
+    std::atomic<const TableSet*> ready_{nullptr};   // worker -> audio
+    std::atomic<const TableSet*> retired_{nullptr}; // audio -> worker (deferred delete)
+    // Worker
+    std::thread thread_;
+    Semaphore wake_; // posted for new requests, retired sets and shutdown
+    std::atomic<bool> running_{false};
+    // Worker owned: remaining tones to prefetch for the last cacheable request
+    TableSetKey prefetchKey_{};
+    int prefetchNext_ = 16;
+};
+
+}
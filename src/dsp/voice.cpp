@@ -1,19 +1,16 @@
 #include "dsp/voice.h"
+#include "dsp/fastmath.h"
 #include <cmath>
 
 namespace msm5232 {
 
-static inline float midi_to_freq(int note) {
-    return 440.0f * std::pow(2.0f, (note - 69) / 12.0f);
-}
-
 void Voice::noteOn(int n, int vel) {
     note_ = n;
     velocity_ = std::max(0, std::min(127, vel)) / 127.0f;
-    float f = midi_to_freq(note_);
+    float f = fastmath::midi_to_freq(note_);
     baseFreq_ = f;
-    baseInc_ = (float)len_ * f / sr_;
-    phase_ = 0.0f;
+    baseInc_ = (double)f / (double)sr_ * 4294967296.0;
+    phase_ = 0;
     env_.gate(true);
     active_ = true;
     decim_.reset();
@@ -23,65 +20,50 @@ void Voice::noteOff() {
     env_.gate(false);
 }
 
-float Voice::render(float pitchRatio) {
-    if (!table_ || !active_) return 0.0f;
-    float e = env_.process();
-    if (!env_.isActive() && e <= 0.0f) { active_ = false; return 0.0f; }
-
-    int iBase = static_cast<int>(phase_);
-    int stride = msm5232::kTableSize / len_; // e.g., 4 for 32, 2 for 64, 1 for 128
-    int maskN = msm5232::kTableSize - 1;
-    int idx0 = (iBase * stride) & maskN;           // current sample
-    float s = (*table_)[idx0]; // direct lookup, no cubic interpolation
-
-    float inc = baseInc_ * (pitchRatio > 0.f ? pitchRatio : 0.f);
-    phase_ += inc;
-    if (phase_ >= (float)len_) phase_ -= (float)len_;
-    return s * e * velocity_;
+void Voice::renderEnvelope(float* out, int stride, int n) {
+    if (active_) {
+        // Stage runs in closed form; zeros after the release ends
+        env_.processBlock(out, n, stride);
+        if (!env_.isActive()) active_ = false;
+        return;
+    }
+    for (int i = 0; i < n; ++i) out[i * stride] = 0.0f;
 }
 
-float Voice::renderFromTwoTables(const Table* tblA, const Table* tblB, float mix, float pitchRatio) {
-    if ((!tblA && !tblB) || !active_) return 0.0f;
-    float e = env_.process();
-    if (!env_.isActive() && e <= 0.0f) { active_ = false; return 0.0f; }
-
-    int iBase = static_cast<int>(phase_);
-    int stride = msm5232::kTableSize / len_;
-    int maskN = msm5232::kTableSize - 1;
-    int idx0 = (iBase * stride) & maskN;
-    float sA = tblA ? (*tblA)[idx0] : 0.0f;
-    float sB = tblB ? (*tblB)[idx0] : 0.0f;
-    // simple linear crossfade between two band tables
-    float s = sA * (1.0f - mix) + sB * mix;
-
-    float inc = baseInc_ * (pitchRatio > 0.f ? pitchRatio : 0.f);
-    phase_ += inc;
-    if (phase_ >= (float)len_) phase_ -= (float)len_;
-    return s * e * velocity_;
+template <int OS>
+void Voice::renderOversampled(const Table* tblA, const Table* tblB, float mix, float pitchRatio, float* out, int n) {
+    if ((!tblA && !tblB) || !active_) return;
+    if (!tblA) tblA = tblB;
+    if (!tblB) tblB = tblA;
+    const Table& a = *tblA;
+    const Table& b = *tblB;
+    static_assert(OS == 2 || OS == 4 || OS == 8, "decimator supports 2x/4x/8x");
+    // Configure per-voice decimator cascade for this OS
+    decim_.configure(OS);
+    const int32_t mask = indexMask();
+    const uint32_t inc = phaseInc(pitchRatio) / (uint32_t)OS;
+    const float wA = 1.0f - mix;
+    uint32_t phase = phase_;
+    float env[kEnvChunk];
+    float sub[kEnvChunk * OS];
+    float dec[kEnvChunk];
+    for (int i0 = 0; i0 < n && active_; i0 += kEnvChunk) {
+        const int m = std::min(kEnvChunk, n - i0);
+        renderEnvelope(env, 1, m);
+        // Render the chunk's subsamples, then decimate them a stage at a time
+        for (int k = 0; k < m * OS; ++k) {
+            const int idx0 = (int)(phase >> kPhaseFracBits) & mask;
+            sub[k] = a[(size_t)idx0] * wA + b[(size_t)idx0] * mix;
+            phase += inc;
+        }
+        decim_.process(sub, dec, m);
+        for (int i = 0; i < m; ++i) out[i0 + i] += dec[i] * env[i] * velocity_;
+    }
+    phase_ = phase;
 }
 
-bool Voice::beginFrame(float& eOut) {
-    if (!active_) { eOut = 0.0f; return false; }
-    float e = env_.process();
-    if (!env_.isActive() && e <= 0.0f) { active_ = false; eOut = 0.0f; return false; }
-    eOut = e;
-    return true;
-}
-
-float Voice::sampleFromTwoTables(const Table* tblA, const Table* tblB, float mix) const {
-    int iBase = static_cast<int>(phase_);
-    int stride = msm5232::kTableSize / len_;
-    int maskN = msm5232::kTableSize - 1;
-    int idx0 = (iBase * stride) & maskN;
-    float sA = tblA ? (*tblA)[idx0] : 0.0f;
-    float sB = tblB ? (*tblB)[idx0] : 0.0f;
-    return sA * (1.0f - mix) + sB * mix;
-}
-
-void Voice::advancePhaseScaled(float pitchRatio, float invOversample) {
-    float inc = baseInc_ * (pitchRatio > 0.f ? pitchRatio : 0.f) * invOversample;
-    phase_ += inc;
-    if (phase_ >= (float)len_) phase_ -= (float)len_;
-}
+template void Voice::renderOversampled<2>(const Table*, const Table*, float, float, float*, int);
+template void Voice::renderOversampled<4>(const Table*, const Table*, float, float, float*, int);
+template void Voice::renderOversampled<8>(const Table*, const Table*, float, float, float*, int);
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "dsp/msm5232_wavetable.h"
 #include "dsp/adsr.h"
+#include "dsp/decimator.h"
 #include <cstdint>
 #include <array>
 #include <algorithm>
@@ -8,6 +9,14 @@
 
 namespace msm5232 {
 
+// Oscillator phase: 32-bit fixed-point fraction of one cycle, wrapping by integer overflow
+// (exact, so pitch never drifts). The top kPhaseIndexBits bits are the index into the
+// kTableSize-sample table; the low kPhaseFracBits bits are the position between table
+// samples (for interpolation).
+constexpr int kPhaseIndexBits = 9;
+constexpr int kPhaseFracBits = 32 - kPhaseIndexBits;
+static_assert((1 << kPhaseIndexBits) == kTableSize, "phase index must cover the table");
+
 struct NoteEvent {
     int type; // 0=off, 1=on
     int note; // 0..127
@@ -17,88 +26,45 @@ struct NoteEvent {
 class Voice {
 public:
     void setSampleRate(float sr) { sr_ = sr; env_.setSampleRate(sr); }
-    void setTable(const Table* t, int effectiveLen) { table_ = t; len_ = effectiveLen; }
+    // Effective table length (64/128/256); tables themselves are passed per render call
+    void setTableLen(int effectiveLen) { len_ = effectiveLen; }
     void setADSR(const ADSRParams& p) { env_.set(p); }
     void noteOn(int note, int vel);
     void noteOff();
     bool active() const { return active_; }
     int note() const { return note_; }
-    float render(float pitchRatio);
-    // Render using external table(s) chosen per-sample (bandlimited sets)
-    // tables: array of pointers to tables (all length kTableSize)
-    // num: number of tables
-    // idxA/idxB: chosen adjacent table indices and crossfade 0..1 between them
-    float renderFromTwoTables(const Table* tblA, const Table* tblB, float mix, float pitchRatio);
+    // HQ: OS (2/4/8) subsamples per output sample through the per-voice half-band decimator
+    // (envelope at base rate), decimated in blocks of kEnvChunk outputs. Control values are
+    // held for the block; output is accumulated into out[0..n).
+    template <int OS>
+    void renderOversampled(const Table* tblA, const Table* tblB, float mix, float pitchRatio, float* out, int n);
+    // VoiceBank support: the bank loads phase/increment, renders the table reads and stores the phase back
+    uint32_t phase() const { return phase_; }
+    void setPhase(uint32_t p) { phase_ = p; }
+    // Fixed-point increment per sample (clamped below half a cycle, i.e. Nyquist)
+    uint32_t phaseInc(float pitchRatio) const {
+        const double x = baseInc_ * (double)(pitchRatio > 0.f ? pitchRatio : 0.f);
+        return x < 2147483647.0 ? (uint32_t)x : 0x7FFFFFFFu;
+    }
+    // Table index = (phase >> kPhaseFracBits) & indexMask(): steps of kTableSize / len
+    int32_t indexMask() const { return (kTableSize - 1) & ~(kTableSize / len_ - 1); }
+    // Write the envelope for n samples to out[i * stride]; zeros after the envelope ends (deactivates the voice)
+    void renderEnvelope(float* out, int stride, int n);
     float baseFreq() const { return baseFreq_; }
     float velocity() const { return velocity_; }
-    // HQ oversampling helpers (process envelope once, sample/advance phase manually)
-    bool beginFrame(float& eOut);
-    float sampleFromTwoTables(const Table* tblA, const Table* tblB, float mix) const;
-    void advancePhaseScaled(float pitchRatio, float invOversample);
-    // Simple FIR decimator for internal oversampling (per-voice state)
-    struct DecimFIR {
-        int os = 1;              // decimation factor (1/2/4/8)
-        int tapsN = 0;           // number of FIR taps (odd)
-        int idx = 0;             // write index into delay line
-        std::array<float, 128> z{}; // delay line for oversampled input (enough for taps up to 128)
-        std::array<float, 128> h{}; // taps
-        void reset() { idx = 0; std::fill(z.begin(), z.end(), 0.0f); }
-        static float sinc(float x) { return (std::fabs(x) < 1e-6f) ? 1.0f : std::sin(x)/x; }
-        static void makeLowpass(int L, float fc, std::array<float,128>& out) {
-            // Hamming windowed-sinc, normalized to DC gain 1.0
-            int M = L - 1; int mid = M / 2; const float twoPi = 6.28318530717958647692f;
-            float sum = 0.0f;
-            for (int n = 0; n < L; ++n) {
-                float w = 0.54f - 0.46f * std::cos(twoPi * n / float(M));
-                float x = twoPi * fc * (float(n - mid));
-                float hn = 2.0f * fc * sinc(x);
-                out[(size_t)n] = w * hn;
-                sum += out[(size_t)n];
-            }
-            if (std::fabs(sum) > 1e-9f) {
-                float g = 1.0f / sum; for (int n = 0; n < L; ++n) out[(size_t)n] *= g;
-            }
-        }
-        void configure(int newOS) {
-            if (newOS < 1) newOS = 1; if (newOS > 8) newOS = 8;
-            if (newOS == os && tapsN > 0) return;
-            os = newOS; reset();
-            // Modest tap lengths per OS (odd, linear phase)
-            int L = (os == 2 ? 17 : os == 4 ? 25 : os == 8 ? 33 : 1);
-            tapsN = L;
-            float fc = 0.45f / float(os); // normalized cutoff (Nyquist guard)
-            makeLowpass(L, fc, h);
-        }
-        inline void push(float x) {
-            if (tapsN <= 0) return;
-            idx = (idx + 1) & 127; // wrap (size 128)
-            z[(size_t)idx] = x;
-        }
-        inline float output() const {
-            if (tapsN <= 0) return z[(size_t)idx];
-            float acc = 0.0f;
-            int j = idx;
-            for (int n = 0; n < tapsN; ++n) {
-                acc += h[(size_t)n] * z[(size_t)j];
-                // manual wrap backward
-                if (--j < 0) j = 127;
-            }
-            return acc;
-        }
-    };
-    DecimFIR& decim() { return decim_; }
+    Decimator& decim() { return decim_; }
 private:
+    static constexpr int kEnvChunk = 32; // envelope/decimator block (per-voice HQ path)
     float sr_ = 48000.0f;
-    const Table* table_ = nullptr;
     ADSR env_{};
     int note_ = -1;
     float velocity_ = 0.0f;
-    float phase_ = 0.0f; // 0..32
-    float baseInc_ = 0.0f; // increment at ratio=1.0
+    uint32_t phase_ = 0;    // fixed-point cycle fraction (see kPhaseIndexBits)
+    double baseInc_ = 0.0;  // phase increment at ratio=1.0, in 2^-32 cycles
     bool active_ = false;
     int len_ = kTableSize; // effective table length (64/128/256)
     float baseFreq_ = 440.0f;
-    DecimFIR decim_{};
+    Decimator decim_{};
 };
 
 }
@@ -0,0 +1,47 @@
+#include "dsp/voice_bank.h"
+
+namespace msm5232 {
+
+void VoiceBank::add(Voice& v, int32_t offsetA, int32_t offsetB, float mix, float pitchRatio, int n) {
+    const int l = count++;
+    voices[l] = &v;
+    offA[l] = offsetA;
+    offB[l] = offsetB;
+    phase[l] = v.phase();
+    inc[l] = v.phaseInc(pitchRatio);
+    idxMask[l] = v.indexMask();
+    wA[l] = 1.0f - mix;
+    wB[l] = mix;
+    vel[l] = v.velocity();
+    v.renderEnvelope(&env[0][l], kLanes, n);
+}
+
+void VoiceBank::addOversampled(Voice& v, int32_t offsetA, int32_t offsetB, float mix, float pitchRatio, int os, int n) {
+    const int l = count;
+    add(v, offsetA, offsetB, mix, pitchRatio, 0);
+    inc[l] /= (uint32_t)os;
+    // Envelope at the base rate into every os-th row, then hold it across the subsamples
+    v.renderEnvelope(&env[0][l], kLanes * os, n);
+    for (int i = n - 1; i >= 0; --i) {
+        const float e = env[i * os][l];
+        for (int k = 0; k < os; ++k) env[i * os + k][l] = e;
+    }
+}
+
+void VoiceBank::render(float* bus, int n) {
+    if (count == 0) return;
+    // Park unused lanes on a valid index so kernels may process full vectors
+    for (int l = count; l < kLanes; ++l) {
+        offA[l] = offB[l] = idxMask[l] = 0;
+        phase[l] = inc[l] = 0;
+    }
+    kernels->renderBank(*this, n);
+    for (int l = 0; l < count; ++l) voices[l]->setPhase(phase[l]);
+    for (int i = 0; i < n; ++i) {
+        float acc = bus[i];
+        for (int l = 0; l < count; ++l) acc += out[i][l];
+        bus[i] = acc;
+    }
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "dsp/voice.h"
+#include "dsp/dsp_kernels.h"
+#include <cstdint>
+
+namespace msm5232 {
+
+// Structure-of-arrays view of up to kLanes voices for one control sub-block.
+// Each lane reads from two tables addressed as offsets from one common base (the
+// contiguous storage of a BLSet, or the single base table), which lets the SIMD
+// kernels advance phases and gather samples for 4 (SSE2), 8 (AVX2) or 16 (AVX-512)
+// voices at once.
+struct VoiceBank {
+    static constexpr int kLanes = 16;
+    static constexpr int kMaxBlock = 128; // longest sub-block render() accepts (x oversampling)
+
+    int count = 0;
+    const float* base = nullptr;
+    alignas(64) int32_t offA[kLanes]{};
+    alignas(64) int32_t offB[kLanes]{};
+    alignas(64) uint32_t phase[kLanes]{}; // fixed point, see kPhaseIndexBits
+    alignas(64) uint32_t inc[kLanes]{};
+    alignas(64) int32_t idxMask[kLanes]{}; // Voice::indexMask(): selects the effective length's grid
+    alignas(64) float wA[kLanes]{};     // 1 - mix
+    alignas(64) float wB[kLanes]{};     // mix
+    alignas(64) float vel[kLanes]{};
+    alignas(64) float env[kMaxBlock][kLanes]{}; // [sample][lane]
+    alignas(64) float out[kMaxBlock][kLanes]{}; // [sample][lane]
+    Voice* voices[kLanes]{};
+    const DspKernels* kernels = &dsp_kernels(Isa::Scalar); // set by Synth::setup()
+
+    void clear(const float* tableBase) { count = 0; base = tableBase; }
+    bool full() const { return count == kLanes; }
+    // Load a voice into the next lane and run its envelope for n samples.
+    // offsetA/offsetB: table start relative to base (in samples); mix: crossfade toward B.
+    void add(Voice& v, int32_t offsetA, int32_t offsetB, float mix, float pitchRatio, int n);
+    // As add(), but the lane runs at os times the rate for n base samples (n * os subsamples):
+    // the increment is divided by os and each envelope value is held for os subsamples
+    void addOversampled(Voice& v, int32_t offsetA, int32_t offsetB, float mix, float pitchRatio, int os, int n);
+    // Render all lanes, store phases back and accumulate into bus[0..n) in lane order
+    // (the summation order does not depend on the kernel, so all kernels are bit-identical).
+    void render(float* bus, int n);
+};
+
+}
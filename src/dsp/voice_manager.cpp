@@ -0,0 +1,94 @@
+#include "dsp/voice_manager.h"
+
+namespace msm5232 {
+
+void VoiceManager::init(int count) {
+    if (count < 0) count = 0;
+    prev_.assign((size_t)count, -1);
+    next_.assign((size_t)count, -1);
+    notePrev_.assign((size_t)count, -1);
+    noteNext_.assign((size_t)count, -1);
+    note_.assign((size_t)count, -1);
+    state_.assign((size_t)count, Retired);
+    free_ = held_ = released_ = List{};
+    for (int& h : noteHead_) h = -1;
+    limit_ = count;
+    for (int i = 0; i < count; ++i) pushBack(free_, i, Free);
+}
+
+bool VoiceManager::applyLimit(int limit) {
+    if (limit < 1) limit = 1;
+    if (limit > size()) limit = size();
+    if (limit == limit_) return false;
+    limit_ = limit;
+    // Parameter change only: a linear pass is fine here
+    for (int i = 0; i < size(); ++i) {
+        if (i >= limit_ && state_[(size_t)i] == Free) { unlink(free_, i); state_[(size_t)i] = Retired; }
+        else if (i < limit_ && state_[(size_t)i] == Retired) pushBack(free_, i, Free);
+    }
+    return true;
+}
+
+int VoiceManager::firstBelowLimit(const List& l) const {
+    // Lists are in age order; voices above a lowered limit only linger until they fade out
+    for (int i = l.head; i >= 0; i = next_[(size_t)i])
+        if (i < limit_) return i;
+    return -1;
+}
+
+int VoiceManager::allocate(int note) {
+    int i = free_.head;
+    if (i >= 0) {
+        unlink(free_, i);
+    } else if ((i = firstBelowLimit(released_)) >= 0) {
+        unlink(released_, i);
+    } else if ((i = firstBelowLimit(held_)) >= 0) {
+        unlinkNote(i);
+        unlink(held_, i);
+    } else {
+        return -1;
+    }
+    pushBack(held_, i, Held);
+    note_[(size_t)i] = note;
+    if (note >= 0 && note <= 127) {
+        notePrev_[(size_t)i] = -1;
+        noteNext_[(size_t)i] = noteHead_[(size_t)note];
+        if (noteHead_[(size_t)note] >= 0) notePrev_[(size_t)noteHead_[(size_t)note]] = i;
+        noteHead_[(size_t)note] = i;
+    }
+    return i;
+}
+
+void VoiceManager::pushBack(List& l, int i, State s) {
+    state_[(size_t)i] = s;
+    prev_[(size_t)i] = l.tail;
+    next_[(size_t)i] = -1;
+    if (l.tail >= 0) next_[(size_t)l.tail] = i; else l.head = i;
+    l.tail = i;
+}
+
+void VoiceManager::unlink(List& l, int i) {
+    const int p = prev_[(size_t)i];
+    const int n = next_[(size_t)i];
+    if (p >= 0) next_[(size_t)p] = n; else l.head = n;
+    if (n >= 0) prev_[(size_t)n] = p; else l.tail = p;
+    prev_[(size_t)i] = next_[(size_t)i] = -1;
+}
+
+void VoiceManager::unlinkNote(int i) {
+    const int note = note_[(size_t)i];
+    if (note < 0 || note > 127) return;
+    const int p = notePrev_[(size_t)i];
+    const int n = noteNext_[(size_t)i];
+    if (p >= 0) noteNext_[(size_t)p] = n; else noteHead_[(size_t)note] = n;
+    if (n >= 0) notePrev_[(size_t)n] = p;
+    notePrev_[(size_t)i] = noteNext_[(size_t)i] = -1;
+    note_[(size_t)i] = -1;
+}
+
+void VoiceManager::retire(int i) {
+    if (i < limit_) pushBack(free_, i, Free);
+    else state_[(size_t)i] = Retired;
+}
+
+}
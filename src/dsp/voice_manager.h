@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace msm5232 {
+
+// Voice allocation bookkeeping for Synth. Every voice index is on exactly one of three
+// intrusive lists: free, held (gate on, in note-on order) or released (gate off, in
+// release order). Held voices are also chained per MIDI note, so allocation, note-off
+// and stealing cost O(1) per voice touched instead of a scan over the whole pool.
+class VoiceManager {
+public:
+    explicit VoiceManager(int count = 0) { init(count); }
+    // Size the pool (allocates; not for the audio thread). All voices start free.
+    void init(int count);
+    int size() const { return (int)state_.size(); }
+    // Only voices [0, limit) are handed out. Held voices above a lowered limit are moved to
+    // the released list (fn(index) is called so the caller can key them off); they finish
+    // their release and retire.
+    template <typename Fn>
+    void setLimit(int limit, Fn fn) {
+        if (!applyLimit(limit)) return;
+        int i = held_.head;
+        while (i >= 0) {
+            const int nextI = next_[(size_t)i];
+            if (i >= limit_) {
+                unlinkNote(i);
+                unlink(held_, i);
+                pushBack(released_, i, Released);
+                fn(i);
+            }
+            i = nextI;
+        }
+    }
+    // Voice for a new note: a free one, else steal the oldest releasing voice, else the
+    // oldest held one (so sustained notes are the last to be cut). Only voices below the
+    // limit are stolen. -1 if the pool is empty.
+    int allocate(int note);
+    // Move every held voice of note to the released list; calls fn(index) for each
+    template <typename Fn>
+    void release(int note, Fn fn) {
+        if (note < 0 || note > 127) return;
+        int i = noteHead_[(size_t)note];
+        while (i >= 0) {
+            const int nextI = noteNext_[(size_t)i];
+            unlinkNote(i);
+            unlink(held_, i);
+            pushBack(released_, i, Released);
+            fn(i);
+            i = nextI;
+        }
+    }
+    // No voice is held or releasing
+    bool idle() const { return held_.head < 0 && released_.head < 0; }
+    // Calls fn(index) for every held and released voice (the ones that may be sounding)
+    template <typename Fn>
+    void forEachBusy(Fn fn) const {
+        for (int i = held_.head; i >= 0; i = next_[(size_t)i]) fn(i);
+        for (int i = released_.head; i >= 0; i = next_[(size_t)i]) fn(i);
+    }
+    // Return voices whose envelope has finished to the free list; isActive(index) -> bool
+    template <typename Fn>
+    void reclaim(Fn isActive) {
+        reclaimList(held_, isActive);
+        reclaimList(released_, isActive);
+    }
+private:
+    enum State : uint8_t { Free, Held, Released, Retired };
+    struct List { int head = -1; int tail = -1; };
+    void pushBack(List& l, int i, State s);
+    void unlink(List& l, int i);
+    void unlinkNote(int i);
+    void retire(int i); // free, or parked if above the limit
+    bool applyLimit(int limit); // false if unchanged
+    int firstBelowLimit(const List& l) const;
+    List& listOf(State s) { return s == Held ? held_ : s == Released ? released_ : free_; }
+    template <typename Fn>
+    void reclaimList(List& l, Fn& isActive) {
+        int i = l.head;
+        while (i >= 0) {
+            const int nextI = next_[(size_t)i];
+            if (!isActive(i)) {
+                if (state_[(size_t)i] == Held) unlinkNote(i);
+                unlink(l, i);
+                retire(i);
+            }
+            i = nextI;
+        }
+    }
+
+    int limit_ = 0;
+    List free_{}, held_{}, released_{};
+    std::vector<int> prev_, next_;         // links within the voice's state list
+    std::vector<int> notePrev_, noteNext_; // links within the held-note chain
+    std::vector<int> note_;
+    std::vector<State> state_;
+    int noteHead_[128];
+};
+
+}
@@ -0,0 +1,65 @@
+#include "dsp/worker_pool.h"
+#include "dsp/rt_check.h"
+
+namespace msm5232 {
+
+WorkerPool::WorkerPool(int workers) {
+    for (int w = 1; w < workers; ++w) threads_.emplace_back([this, w] { loop(w); });
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        quit_ = true;
+    }
+    start_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+void WorkerPool::runImpl(int tasks, TaskFn fn, void* ctx) {
+    if (tasks <= 0) return;
+    if (threads_.empty() || tasks == 1) {
+        for (int t = 0; t < tasks; ++t) fn(ctx, t, 0);
+        return;
+    }
+    rtcheck::onLock("WorkerPool mutex");
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        fn_ = fn;
+        ctx_ = ctx;
+        tasks_ = tasks;
+        next_.store(0, std::memory_order_relaxed);
+        busy_ = (int)threads_.size();
+        ++generation_;
+    }
+    start_.notify_all();
+    work(0);
+    std::unique_lock<std::mutex> lk(m_);
+    done_.wait(lk, [this] { return busy_ == 0; });
+}
+
+void WorkerPool::work(int worker) {
+    for (int t = next_.fetch_add(1, std::memory_order_relaxed); t < tasks_;
+         t = next_.fetch_add(1, std::memory_order_relaxed)) {
+        fn_(ctx_, t, worker);
+    }
+}
+
+void WorkerPool::loop(int worker) {
+    unsigned seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(m_);
+            start_.wait(lk, [&] { return quit_ || generation_ != seen; });
+            if (quit_) return;
+            seen = generation_;
+        }
+        work(worker);
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            if (--busy_ == 0) done_.notify_one();
+        }
+    }
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace msm5232 {
+
+// Fixed set of worker threads for parallel-for over independent tasks (offline
+// rendering only: run() blocks on a mutex/condition variable). The calling thread
+// takes part as worker 0, so a pool of N workers starts N - 1 threads.
+class WorkerPool {
+public:
+    explicit WorkerPool(int workers);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int workers() const { return (int)threads_.size() + 1; }
+    // Calls fn(task, worker) for every task in [0, tasks) and returns when all are done.
+    // Tasks are claimed dynamically; worker is in [0, workers()).
+    template <typename Fn>
+    void run(int tasks, Fn& fn) {
+        runImpl(tasks, [](void* ctx, int task, int worker) { (*static_cast<Fn*>(ctx))(task, worker); }, &fn);
+    }
+
+private:
+    using TaskFn = void (*)(void* ctx, int task, int worker);
+    void runImpl(int tasks, TaskFn fn, void* ctx);
+    void work(int worker);
+    void loop(int worker);
+
+    std::vector<std::thread> threads_;
+    std::mutex m_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    bool quit_ = false;
+    unsigned generation_ = 0;
+    // Current job
+    TaskFn fn_ = nullptr;
+    void* ctx_ = nullptr;
+    int tasks_ = 0;
+    std::atomic<int> next_{0};
+    int busy_ = 0; // workers still inside the current job (guarded by m_)
+};
+
+}
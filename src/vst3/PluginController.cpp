@@ -2,6 +2,7 @@
 #include <public.sdk/source/vst/vsteditcontroller.h>
 #include <public.sdk/source/vst/vstparameters.h>
 #include <pluginterfaces/base/ustring.h>
+#include "vst3/PluginState.h"
 #include <cmath>
 #include <string>
 #include <string>
@@ -9,6 +10,7 @@
 
 using namespace Steinberg;
 using namespace Steinberg::Vst;
+using namespace msm5232::vst3;
 
 namespace {
 // Shared helper (duplicated to avoid cross-TU deps)
@@ -26,31 +28,20 @@ static inline float noiseRatioToNorm(float r) {
     if (x < 0.f) x = 0.f; if (x > 1.f) x = 1.f;
     return x;
 }
-enum ParamIDs : ParamID {
-    kParamTone = 1000,
-    kParamAttack,
-    kParamDecay,
-    kParamSustain,
-    kParamRelease,
-    kParamGain,
-    kParamPolyphony,
-    kParamTableSize,
-    kParamQuantize4,
-    kParamDetune,
-    kParamVibratoDepth,
-    kParamVibratoRate,
-    kParamNoiseAdd, // 0..100% additive noise depth (relative to |signal|)
-    kParamBLQuality, // 0=Off, 1=1/oct .. 8=8/oct
-    kParamHQMode,    // 0=Off, 1=Auto2x, 2=Force2x, 3=Force4x, 4=Force8x
-    kParamPreHighCutMode, // 0=Off, 1=Fixed, 2=ByMaxNote
-    kParamPreHighCutMaxNote, // 0..127
-};
 }
 
 class Msm5232Controller : public EditController {
 public:
     Msm5232Controller() = default;
     static FUnknown* create(void*);
+    tresult PLUGIN_API setComponentState(IBStream* state) SMTG_OVERRIDE {
+        StateValues values;
+        if (!readState(state, values)) return kResultFalse;
+        for (int32 k = 0; k < kNumStateParams; ++k) {
+            if (values[(size_t)k] >= 0.0) setParamNormalized(kParamTone + (ParamID)k, values[(size_t)k]);
+        }
+        return kResultOk;
+    }
     tresult PLUGIN_API getParamStringByValue (ParamID id, ParamValue valueNormalized, String128 string) SMTG_OVERRIDE {
         UString out(string, 128);
         if (id == kParamTone) {
@@ -61,8 +52,8 @@ public:
             return kResultOk;
         }
         if (id == kParamPolyphony) {
-            int poly = 1 + (int)std::floor(valueNormalized * 31.0 + 0.5);
-            if (poly < 1) poly = 1; if (poly > 32) poly = 32;
+            int poly = 1 + (int)std::floor(valueNormalized * 127.0 + 0.5);
+            if (poly < 1) poly = 1; if (poly > 128) poly = 128;
             std::string s = std::to_string(poly);
             out.fromAscii(s.c_str());
             return kResultOk;
@@ -127,6 +118,10 @@ public:
             out.fromAscii(names[idx]);
             return kResultOk;
         }
+        if (id == kParamHQPath) {
+            out.fromAscii(valueNormalized >= 0.5 ? "Bus" : "PerVoice");
+            return kResultOk;
+        }
         if (id == kParamPreHighCutMode) {
             int idx = (int)std::floor(valueNormalized * 3.0); // 0..2
             if (idx < 0) idx = 0; if (idx > 2) idx = 2;
@@ -154,8 +149,8 @@ public:
             return kResultOk;
         }
         if (id == kParamPolyphony) {
-            if (v < 1) v = 1; if (v > 32) v = 32;
-            valueNormalized = (v - 1) / 31.0;
+            if (v < 1) v = 1; if (v > 128) v = 128;
+            valueNormalized = (v - 1) / 127.0;
             return kResultOk;
         }
         if (id == kParamTableSize) {
@@ -217,6 +212,12 @@ public:
             valueNormalized = m / 4.0;
             return kResultOk;
         }
+        if (id == kParamHQPath) {
+            if (std::strcmp(ascii, "PerVoice") == 0) { valueNormalized = 0.0; return kResultOk; }
+            if (std::strcmp(ascii, "Bus") == 0) { valueNormalized = 1.0; return kResultOk; }
+            valueNormalized = (std::atoi(ascii) >= 1) ? 1.0 : 0.0;
+            return kResultOk;
+        }
         if (id == kParamPreHighCutMode) {
             if (std::strcmp(ascii, "Off") == 0) { valueNormalized = 0.0; return kResultOk; }
             if (std::strcmp(ascii, "Fixed") == 0) { valueNormalized = 0.5; return kResultOk; }
@@ -243,7 +244,7 @@ public:
         parameters.addParameter( STR16("Sustain"), nullptr, 0, 0.6, 0, kParamSustain );
         parameters.addParameter( STR16("Release"), nullptr, 0, 0.3, 0, kParamRelease );
         parameters.addParameter( STR16("Gain"), nullptr, 0, 0.3, 0, kParamGain );
-        parameters.addParameter( STR16("Polyphony"), nullptr, 31, 31.0/31.0, 0, kParamPolyphony ); // default 32
+        parameters.addParameter( STR16("Polyphony"), nullptr, 127, 31.0/127.0, 0, kParamPolyphony ); // 1..128, default 32
         // Three-step selector: 0=64, 1=128, 2=256 (default 128)
         parameters.addParameter( STR16("TableSize"), nullptr, 2, 0.5, 0, kParamTableSize );
         parameters.addParameter( STR16("Quantize4bit"), nullptr, 1, 1.0, 0, kParamQuantize4 ); // 0/1
@@ -259,6 +260,8 @@ public:
         parameters.addParameter( STR16("Bandlimit"), STR16(""), 8, 0.0, 0, kParamBLQuality );
         // HQ mode selector (0..4)
         parameters.addParameter( STR16("HQMode"), STR16(""), 4, 0.0, 0, kParamHQMode );
+        // HQ path: 0=PerVoice, 1=Bus
+        parameters.addParameter( STR16("HQPath"), STR16(""), 1, 0.0, 0, kParamHQPath );
         // PreHighCut mode (0..2)
         parameters.addParameter( STR16("PreHighCutMode"), STR16(""), 2, 0.0, 0, kParamPreHighCutMode );
         // PreHighCut MaxNote (0..127), default 64
@@ -1,15 +1,19 @@
 #ifdef HAVE_VST3_SDK
 #include "dsp/synth.h"
+#include "vst3/PluginState.h"
 #include <public.sdk/source/vst/vstaudioeffect.h>
 #include <public.sdk/source/vst/vstparameters.h>
 #include <pluginterfaces/vst/ivstaudioprocessor.h>
 #include <pluginterfaces/vst/ivstmidicontrollers.h>
 #include <pluginterfaces/vst/ivstparameterchanges.h>
 #include <pluginterfaces/vst/ivstevents.h>
+#include <algorithm>
 #include <cmath>
+#include <thread>
 
 using namespace Steinberg;
 using namespace Steinberg::Vst;
+using namespace msm5232::vst3;
 
 namespace {
 // Map normalized 0..1 -> noise ratio d (0..100), with fine control in 0..10%
@@ -30,31 +34,15 @@ static inline float noiseRatioToNorm(float r) {
     if (x < 0.f) x = 0.f; if (x > 1.f) x = 1.f;
     return x;
 }
-// Parameter IDs
-enum ParamIDs : ParamID {
-    kParamTone = 1000,
-    kParamAttack,
-    kParamDecay,
-    kParamSustain,
-    kParamRelease,
-    kParamGain,
-    kParamPolyphony,
-    kParamTableSize,
-    kParamQuantize4,
-    kParamDetune, // new: fine detune +/- 0.5 semitone
-    kParamVibratoDepth, // new: vibrato depth 0..0.5 st
-    kParamVibratoRate,  // new: vibrato rate 0..16 Hz
-    kParamNoiseAdd,     // new: additive noise depth 0..100%
-    kParamBLQuality,    // new: bandlimit quality 0=Off, 1..8 bands per octave
-    kParamHQMode,       // new: HQ mode 0=Off,1=Auto2x,2=Force2x,3=Force4x,4=Force8x
-    kParamPreHighCutMode,   // 0=Off,1=Fixed,2=ByMaxNote
-    kParamPreHighCutMaxNote,// 0..127 (default 108)
-};
 }
 
 class Msm5232Processor : public AudioEffect {
 public:
-    Msm5232Processor() { setControllerClass(FUID(0x0B5C2B11,0xF2C84185,0x9F6E3CB5,0x88947733)); }
+    Msm5232Processor() {
+        setControllerClass(FUID(0x0B5C2B11,0xF2C84185,0x9F6E3CB5,0x88947733));
+        stateValues_.fill(-1.0);
+        hostState_.fill(-1.0);
+    }
     static FUnknown* create(void*);
 
     tresult PLUGIN_API initialize(FUnknown* ctx) SMTG_OVERRIDE {
@@ -62,6 +50,8 @@ public:
         if (r != kResultOk) return r;
         addAudioOutput(STR16("Stereo Out"), SpeakerArr::kStereo);
         addEventInput(STR16("MIDI In"), 16);
+        // Voice pool for the full Polyphony range (1..128), allocated by setup()
+        synth_.setVoiceCount(128);
         synth_.setup(48000.0f);
         return kResultOk;
     }
@@ -73,161 +63,329 @@ public:
     }
     tresult PLUGIN_API setupProcessing(ProcessSetup& setup) SMTG_OVERRIDE {
         sampleRate_ = (float)setup.sampleRate;
+        // Offline bounces rebuild tables synchronously (deterministic); realtime uses the builder thread
+        synth_.setRealtime(setup.processMode != kOffline);
+        // Offline bounces also spread voice rendering over all cores (same output as one thread)
+        synth_.setRenderThreads(setup.processMode == kOffline ? (int)std::thread::hardware_concurrency() : 1);
         synth_.setup(sampleRate_);
         return kResultOk;
     }
+    // setState/getState run on the host's thread: values reach the audio thread through
+    // stateIn_ and come back through stateOut_ (no shared writes, no locks)
+    tresult PLUGIN_API setState(IBStream* state) SMTG_OVERRIDE {
+        StateValues values;
+        if (!readState(state, values)) return kResultFalse;
+        // Applied by the audio thread at the start of the next process() call
+        stateIn_.write(values);
+        for (size_t k = 0; k < values.size(); ++k) {
+            if (values[k] >= 0.0) hostState_[k] = values[k];
+        }
+        return kResultOk;
+    }
+    tresult PLUGIN_API getState(IBStream* state) SMTG_OVERRIDE {
+        if (stateOut_.take()) hostState_ = stateOut_.latest();
+        return writeState(state, hostState_) ? kResultOk : kResultFalse;
+    }
     tresult PLUGIN_API process(ProcessData& data) SMTG_OVERRIDE {
-        // Handle incoming parameter changes (including MIDI CC / PitchBend per VST3 convention)
+        if (stateIn_.take()) {
+            const StateValues& values = stateIn_.latest();
+            bool paramsAffectCore = false;
+            for (int32 k = 0; k < kNumStateParams; ++k) {
+                const ParamValue val = values[(size_t)k];
+                if (val < 0.0) continue;
+                const ParamID id = kParamTone + (ParamID)k;
+                const int slot = rampSlot(id);
+                if (slot >= 0) rampLast_[slot] = val;
+                applyParam(id, val, paramsAffectCore);
+            }
+            if (paramsAffectCore) synth_.setParams(params_);
+        }
+        float* L = nullptr;
+        float* R = nullptr;
+        if (data.numOutputs > 0) {
+            auto& bus = data.outputs[0];
+            L = bus.channelBuffers32[0];
+            R = bus.channelBuffers32[1];
+        }
+        const int32 frames = data.numSamples;
+
+        // Sort the parameter queues (including MIDI CC / PitchBend per VST3 convention):
+        // continuous ones are ramped linearly between their points at control rate,
+        // the others are stepped at each point's sampleOffset
+        RampQueue ramps[kNumRamps];
+        int32 numRamps = 0;
+        StepQueue steps[kMaxStepQueues];
+        int32 numSteps = 0;
+        int32 rampEnd = 0; // last ramp point; past it the ramped values are constant
+        // Queues past the arrays (only possible if a host sends several for one ID) apply
+        // their last point at the end of the block
+        int32 overflowFrom = -1;
         if (data.inputParameterChanges) {
             int32 count = data.inputParameterChanges->getParameterCount();
-            bool paramsAffectCore = false;      // Tone/Table/Quantize/BLQuality/ADSR/Gain/Polyphony
             for (int32 i = 0; i < count; ++i) {
                 auto* queue = data.inputParameterChanges->getParameterData(i);
-                if (!queue) continue;
-                int32 pcount = queue->getPointCount();
+                if (!queue || queue->getPointCount() <= 0) continue;
+                const ParamID id = queue->getParameterId();
+                const int slot = rampSlot(id);
+                if (slot >= 0) {
+                    int32 offset; ParamValue val;
+                    if (queue->getPoint(queue->getPointCount() - 1, offset, val) == kResultOk) rampEnd = std::max(rampEnd, offset);
+                    if (numRamps < kNumRamps) ramps[numRamps++] = RampQueue{ queue, slot };
+                    else if (overflowFrom < 0) overflowFrom = i;
+                    mirrorToGui(id, queue, data);
+                } else if (id >= kParamTone && id <= kParamHQPath) { // other IDs have no effect
+                    if (numSteps < kMaxStepQueues) steps[numSteps++] = StepQueue{ queue, 0 };
+                    else if (overflowFrom < 0) overflowFrom = i;
+                }
+            }
+        }
+
+        // Render in spans that end at every note event and stepped point, and at most every
+        // control block while a ramp is running, so timing does not depend on buffer size
+        int32 numEvents = data.inputEvents ? data.inputEvents->getEventCount() : 0;
+        int32 nextEvent = 0;
+        int32 pos = 0;
+        bool silent = true; // every span took Synth's idle path
+        while (true) {
+            // Points and events at or past the end of the block are applied at the end
+            const bool last = pos >= frames;
+            bool paramsAffectCore = false;
+            for (int32 k = 0; k < numSteps; ++k) {
+                StepQueue& sq = steps[k];
                 int32 offset; ParamValue val;
-                if (pcount > 0 && queue->getPoint(pcount - 1, offset, val) == kResultOk) {
-                    switch (queue->getParameterId()) {
-                        case kParamTone: params_.toneMask = 1 + (int)(val * 14.999); paramsAffectCore = true; break;
-                        case kParamAttack: params_.adsr.attack = (float)val * 2.0f; paramsAffectCore = true; break;
-                        case kParamDecay: params_.adsr.decay = (float)val * 2.0f; paramsAffectCore = true; break;
-                        case kParamSustain: params_.adsr.sustain = (float)val; paramsAffectCore = true; break;
-                        case kParamRelease: params_.adsr.release = (float)val * 2.0f; paramsAffectCore = true; break;
-                        case kParamGain: params_.gain = (float)val; paramsAffectCore = true; break;
-                        case kParamPolyphony: params_.polyphony = 1 + (int)std::floor(val * 31.0); paramsAffectCore = true; break;
-                        case kParamTableSize: {
-                            // 64 / 128 / 256 の3段
-                            if (val < (1.0/3.0)) params_.tableLen = 64;
-                            else if (val < (2.0/3.0)) params_.tableLen = 128;
-                            else params_.tableLen = 256;
-                            paramsAffectCore = true;
-                        } break;
-                        case kParamQuantize4: params_.quantize4 = (val >= 0.5); paramsAffectCore = true; break;
-                        case kParamDetune: {
-                            // Map 0..1 -> -0.5..+0.5 semitones
-                            float semis = (float(val) - 0.5f) * 1.0f;
-                            synth_.setDetuneSemis(semis);
-                        } break;
-                        case kParamVibratoDepth: {
-                            // 0..1 -> 0..0.5 st
-                            float depthSemis = (float)val * 0.5f;
-                            synth_.setVibratoDepthSemis(depthSemis);
-                            // If precut depends on vibrato depth, rebuild
-                            if (params_.preHighCutMode == 2) paramsAffectCore = true;
-                        } break;
-                        case kParamVibratoRate: {
-                            // 0..1 -> 0..16 Hz
-                            float hz = (float)val * 16.0f;
-                            synth_.setVibratoRateHz(hz);
-                        } break;
-                        case kParamNoiseAdd: {
-                            // Normalized 0..1 -> ratio 0..100 (1:100)
-                            float ratio = noiseNormToRatio((float)val);
-                            synth_.setNoiseAdd(ratio);
-                        } break;
-                        case kParamBLQuality: {
-                            // 0..1 -> 0..8
-                            int q = (int)std::floor(val * 9.0);
-                            if (q < 0) q = 0; if (q > 8) q = 8;
-                            params_.blQuality = q;
-                            paramsAffectCore = true;
-                        } break;
-                        case kParamHQMode: {
-                            // 0..1 -> 0..4
-                            int m = (int)std::floor(val * 5.0);
-                            if (m < 0) m = 0; if (m > 4) m = 4;
-                            params_.hqMode = m;
-                            paramsAffectCore = true; // affects runtime decision but safe
-                        } break;
-                        case kPitchBend: {
-                            // VST3 normalized pitch bend (0..1, 0.5 center). Use +/-2 semitone range.
-                            float semis = (float(val) - 0.5f) * 4.0f;
-                            synth_.setPitchBendSemis(semis);
-                        } break;
-                        case kCtrlModWheel: {
-                            // CC#1 0..1 -> -0.5..+0.5 st detune, also reflect to Detune parameter for GUI
-                            float semis = (float(val) - 0.5f) * 1.0f;
-                            synth_.setDetuneSemis(semis);
-                            if (data.outputParameterChanges) {
-                                int32 indexOut = 0; IParamValueQueue* outQ = data.outputParameterChanges->addParameterData(kParamDetune, indexOut);
-                                if (outQ) {
-                                    int32 dummy = 0;
-                                    outQ->addPoint(offset, val, dummy);
-                                }
-                            }
-                        } break;
-                        case kParamPreHighCutMode: {
-                            // 0..1 -> 0..2
-                            int m = (int)std::floor(val * 3.0);
-                            if (m < 0) m = 0; if (m > 2) m = 2;
-                            params_.preHighCutMode = m;
-                            paramsAffectCore = true;
-                        } break;
-                        case kParamPreHighCutMaxNote: {
-                            int note = (int)std::floor(val * 127.0 + 0.5);
-                            if (note < 0) note = 0; if (note > 127) note = 127;
-                            params_.preHighCutMaxNote = note;
-                            paramsAffectCore = true;
-                        } break;
-                        case 24: { // CC#24 -> Vibrato Depth
-                            float depthSemis = (float)val * 0.5f;
-                            synth_.setVibratoDepthSemis(depthSemis);
-                            // Reflect to GUI VibratoDepth parameter
-                            if (data.outputParameterChanges) {
-                                int32 indexOut = 0; IParamValueQueue* outQ = data.outputParameterChanges->addParameterData(kParamVibratoDepth, indexOut);
-                                if (outQ) {
-                                    int32 dummy = 0;
-                                    outQ->addPoint(offset, val, dummy);
-                                }
-                            }
-                        } break;
-                        case 25: { // CC#25 -> Vibrato Rate
-                            float hz = (float)val * 16.0f;
-                            synth_.setVibratoRateHz(hz);
-                            // Reflect to GUI VibratoRate parameter
-                            if (data.outputParameterChanges) {
-                                int32 indexOut = 0; IParamValueQueue* outQ = data.outputParameterChanges->addParameterData(kParamVibratoRate, indexOut);
-                                if (outQ) {
-                                    int32 dummy = 0;
-                                    // Map 0..16 Hz -> normalized 0..1
-                                    outQ->addPoint(offset, val, dummy);
-                                }
-                            }
-                        } break;
-                    }
+                while (sq.next < sq.queue->getPointCount() && sq.queue->getPoint(sq.next, offset, val) == kResultOk
+                       && (offset <= pos || last)) {
+                    applyParam(sq.queue->getParameterId(), val, paramsAffectCore);
+                    ++sq.next;
                 }
             }
-            if (paramsAffectCore) {
-                synth_.setParams(params_);
+            for (int32 k = 0; k < numRamps; ++k) {
+                applyParam(rampIds[ramps[k].slot], rampValueAt(ramps[k], pos), paramsAffectCore);
             }
-        }
+            if (paramsAffectCore) synth_.setParams(params_);
+            for (; nextEvent < numEvents; ++nextEvent) {
+                Event e;
+                if (data.inputEvents->getEvent(nextEvent, e) != kResultOk) continue;
+                if (e.sampleOffset > pos && !last) break;
+                if (e.type == Event::kNoteOnEvent) {
+                    synth_.noteOn(e.noteOn.pitch, int(e.noteOn.velocity * 127.0f));
+                } else if (e.type == Event::kNoteOffEvent) {
+                    synth_.noteOff(e.noteOff.pitch);
+                }
+            }
+            if (last) break;
 
-        if (data.inputEvents) {
-            int32 num = data.inputEvents->getEventCount();
-            for (int32 i = 0; i < num; ++i) {
-                Event e; if (data.inputEvents->getEvent(i, e) == kResultOk) {
-                    if (e.type == Event::kNoteOnEvent) {
-                        synth_.noteOn(e.noteOn.pitch, int(e.noteOn.velocity * 127.0f));
-                    } else if (e.type == Event::kNoteOffEvent) {
-                        synth_.noteOff(e.noteOff.pitch);
-                    }
+            int32 end = frames;
+            if (pos < rampEnd) end = std::min(end, pos + (int32)msm5232::Synth::kControlBlock);
+            if (nextEvent < numEvents) {
+                Event e;
+                if (data.inputEvents->getEvent(nextEvent, e) == kResultOk) end = std::min(end, std::max(e.sampleOffset, pos + 1));
+            }
+            for (int32 k = 0; k < numSteps; ++k) {
+                int32 offset; ParamValue val;
+                if (steps[k].next < steps[k].queue->getPointCount()
+                    && steps[k].queue->getPoint(steps[k].next, offset, val) == kResultOk) {
+                    end = std::min(end, std::max(offset, pos + 1));
                 }
             }
+            if (L && !synth_.process(L + pos, R + pos, end - pos)) silent = false;
+            pos = end;
         }
-
-        if (data.numOutputs > 0) {
-            auto& bus = data.outputs[0];
-            float* L = bus.channelBuffers32[0];
-            float* R = bus.channelBuffers32[1];
-            synth_.process(L, R, data.numSamples);
+        // Let the host skip downstream processing of idle instances
+        if (data.numOutputs > 0) data.outputs[0].silenceFlags = silent ? 0x3 : 0;
+        // The next block ramps from where this one ended
+        for (int32 k = 0; k < numRamps; ++k) {
+            int32 offset; ParamValue val;
+            if (ramps[k].queue->getPoint(ramps[k].queue->getPointCount() - 1, offset, val) == kResultOk) {
+                rampLast_[ramps[k].slot] = val;
+            }
+        }
+        if (overflowFrom >= 0) applyOverflow(data, overflowFrom, ramps, numRamps, steps, numSteps);
+        // Vibrato depth sets the ByMaxNote pre-cut: one table request per block, for the
+        // value the block ended on, instead of one per control block of a ramp
+        if (precutDirty_) {
+            precutDirty_ = false;
+            synth_.setParams(params_);
+        }
+        if (stateChanged_) {
+            stateChanged_ = false;
+            stateOut_.write(stateValues_);
         }
         return kResultOk;
     }
 
 private:
+    // Continuous parameters that are ramped between automation points
+    static constexpr int kNumRamps = 9;
+    static constexpr ParamID rampIds[kNumRamps] = {
+        kParamGain, kParamDetune, kParamVibratoDepth, kParamVibratoRate, kParamNoiseAdd,
+        kPitchBend, kCtrlModWheel, 24, 25,
+    };
+    // One queue per parameter ID: every non-ramped parameter fits
+    static constexpr int32 kMaxStepQueues = kParamHQPath - kParamTone + 1;
+    struct RampQueue { IParamValueQueue* queue; int slot; };
+    struct StepQueue { IParamValueQueue* queue; int32 next; };
+
+    static int rampSlot(ParamID id) {
+        for (int k = 0; k < kNumRamps; ++k) if (rampIds[k] == id) return k;
+        return -1;
+    }
+    // Last point of every queue from index first on that did not get a ramp/step slot
+    void applyOverflow(ProcessData& data, int32 first, const RampQueue* ramps, int32 numRamps,
+                       const StepQueue* steps, int32 numSteps) {
+        bool paramsAffectCore = false;
+        const int32 count = data.inputParameterChanges->getParameterCount();
+        for (int32 i = first; i < count; ++i) {
+            auto* queue = data.inputParameterChanges->getParameterData(i);
+            if (!queue || queue->getPointCount() <= 0) continue;
+            bool held = false;
+            for (int32 k = 0; k < numRamps; ++k) held = held || ramps[k].queue == queue;
+            for (int32 k = 0; k < numSteps; ++k) held = held || steps[k].queue == queue;
+            int32 offset; ParamValue val;
+            if (held || queue->getPoint(queue->getPointCount() - 1, offset, val) != kResultOk) continue;
+            const int slot = rampSlot(queue->getParameterId());
+            if (slot >= 0) rampLast_[slot] = val;
+            applyParam(queue->getParameterId(), val, paramsAffectCore);
+        }
+        if (paramsAffectCore) synth_.setParams(params_);
+    }
+    // Linear interpolation of the queue at pos; before the first point, ramps from the
+    // value the previous block ended on (or holds the first point if there is none)
+    ParamValue rampValueAt(const RampQueue& r, int32 pos) const {
+        int32 prevOffset = 0;
+        ParamValue prev = rampLast_[r.slot];
+        const int32 n = r.queue->getPointCount();
+        for (int32 k = 0; k < n; ++k) {
+            int32 offset; ParamValue val;
+            if (r.queue->getPoint(k, offset, val) != kResultOk) continue;
+            if (prev < 0.0) prev = val;
+            if (offset >= pos) {
+                if (offset <= prevOffset) return val;
+                return prev + (val - prev) * (double)(pos - prevOffset) / (double)(offset - prevOffset);
+            }
+            prevOffset = offset;
+            prev = val;
+        }
+        return prev;
+    }
+    // CC input mirrors to the GUI parameter it controls (every point, at its offset)
+    static void mirrorToGui(ParamID id, IParamValueQueue* queue, ProcessData& data) {
+        ParamID target;
+        if (id == kCtrlModWheel) target = kParamDetune;
+        else if (id == 24) target = kParamVibratoDepth;
+        else if (id == 25) target = kParamVibratoRate;
+        else return;
+        if (!data.outputParameterChanges) return;
+        int32 indexOut = 0; IParamValueQueue* outQ = data.outputParameterChanges->addParameterData(target, indexOut);
+        if (!outQ) return;
+        const int32 n = queue->getPointCount();
+        for (int32 k = 0; k < n; ++k) {
+            int32 offset; ParamValue val;
+            if (queue->getPoint(k, offset, val) != kResultOk) continue;
+            int32 dummy = 0;
+            outQ->addPoint(offset, val, dummy);
+        }
+    }
+    void applyParam(ParamID id, ParamValue val, bool& paramsAffectCore) {
+        if (id >= kParamTone && id <= kParamHQPath && stateValues_[id - kParamTone] != val) {
+            stateValues_[id - kParamTone] = val;
+            stateChanged_ = true;
+        }
+        switch (id) {
+            case kParamTone: params_.toneMask = 1 + (int)(val * 14.999); paramsAffectCore = true; break;
+            case kParamAttack: params_.adsr.attack = (float)val * 2.0f; paramsAffectCore = true; break;
+            case kParamDecay: params_.adsr.decay = (float)val * 2.0f; paramsAffectCore = true; break;
+            case kParamSustain: params_.adsr.sustain = (float)val; paramsAffectCore = true; break;
+            case kParamRelease: params_.adsr.release = (float)val * 2.0f; paramsAffectCore = true; break;
+            case kParamGain: {
+                // Ramped: set directly (no table-set lookup)
+                params_.gain = (float)val;
+                synth_.setGain(params_.gain);
+            } break;
+            case kParamPolyphony: params_.polyphony = 1 + (int)std::floor(val * 127.0 + 0.5); paramsAffectCore = true; break;
+            case kParamTableSize: {
+                // 64 / 128 / 256 の3段
+                if (val < (1.0/3.0)) params_.tableLen = 64;
+                else if (val < (2.0/3.0)) params_.tableLen = 128;
+                else params_.tableLen = 256;
+                paramsAffectCore = true;
+            } break;
+            case kParamQuantize4: params_.quantize4 = (val >= 0.5); paramsAffectCore = true; break;
+            case kParamDetune:
+            case kCtrlModWheel: {
+                // Map 0..1 -> -0.5..+0.5 semitones (CC#1 drives Detune)
+                float semis = (float(val) - 0.5f) * 1.0f;
+                synth_.setDetuneSemis(semis);
+            } break;
+            case kParamVibratoDepth:
+            case 24: { // CC#24 -> Vibrato Depth
+                // 0..1 -> 0..0.5 st
+                float depthSemis = (float)val * 0.5f;
+                synth_.setVibratoDepthSemis(depthSemis);
+                // If precut depends on vibrato depth, rebuild once at the end of the block
+                if (params_.preHighCutMode == 2) precutDirty_ = true;
+            } break;
+            case kParamVibratoRate:
+            case 25: { // CC#25 -> Vibrato Rate
+                // 0..1 -> 0..16 Hz
+                float hz = (float)val * 16.0f;
+                synth_.setVibratoRateHz(hz);
+            } break;
+            case kParamNoiseAdd: {
+                // Normalized 0..1 -> ratio 0..100 (1:100)
+                float ratio = noiseNormToRatio((float)val);
+                synth_.setNoiseAdd(ratio);
+            } break;
+            case kParamBLQuality: {
+                // 0..1 -> 0..8
+                int q = (int)std::floor(val * 9.0);
+                if (q < 0) q = 0; if (q > 8) q = 8;
+                params_.blQuality = q;
+                paramsAffectCore = true;
+            } break;
+            case kParamHQMode: {
+                // 0..1 -> 0..4
+                int m = (int)std::floor(val * 5.0);
+                if (m < 0) m = 0; if (m > 4) m = 4;
+                params_.hqMode = m;
+                paramsAffectCore = true; // affects runtime decision but safe
+            } break;
+            case kParamHQPath: {
+                params_.hqPath = (val >= 0.5) ? 1 : 0;
+                paramsAffectCore = true;
+            } break;
+            case kPitchBend: {
+                // VST3 normalized pitch bend (0..1, 0.5 center). Use +/-2 semitone range.
+                float semis = (float(val) - 0.5f) * 4.0f;
+                synth_.setPitchBendSemis(semis);
+            } break;
+            case kParamPreHighCutMode: {
+                // 0..1 -> 0..2
+                int m = (int)std::floor(val * 3.0);
+                if (m < 0) m = 0; if (m > 2) m = 2;
+                params_.preHighCutMode = m;
+                paramsAffectCore = true;
+            } break;
+            case kParamPreHighCutMaxNote: {
+                int note = (int)std::floor(val * 127.0 + 0.5);
+                if (note < 0) note = 0; if (note > 127) note = 127;
+                params_.preHighCutMaxNote = note;
+                paramsAffectCore = true;
+            } break;
+        }
+    }
+
     msm5232::Synth synth_{};
     msm5232::SynthParams params_{};
     float sampleRate_ = 48000.0f;
+    ParamValue rampLast_[kNumRamps] = { -1, -1, -1, -1, -1, -1, -1, -1, -1 }; // < 0: no value yet
+    bool precutDirty_ = false; // vibrato depth changed while the pre-cut follows it
+    // Last normalized value of each parameter (< 0: never set); audio thread
+    StateValues stateValues_;
+    bool stateChanged_ = false; // published to stateOut_ at the end of process()
+    StateMailbox stateIn_;      // setState -> audio thread
+    StateMailbox stateOut_;     // audio thread -> getState
+    StateValues hostState_;     // what getState writes; host thread only
 };
 
 // Out-of-class definition to ensure linker symbol exists across translation units
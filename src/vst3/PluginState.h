@@ -0,0 +1,108 @@
+#pragma once
+#ifdef HAVE_VST3_SDK
+// Shared by the processor and the controller: parameter IDs, the component state layout
+// with its version migrations, and the lock-free hand-over of parameter values between
+// the audio thread and the host's (UI) thread.
+#include <pluginterfaces/base/ibstream.h>
+#include <pluginterfaces/vst/vsttypes.h>
+#include <base/source/fstreamer.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+namespace msm5232 {
+namespace vst3 {
+
+using Steinberg::int32;
+using Steinberg::Vst::ParamID;
+using Steinberg::Vst::ParamValue;
+
+// Parameter IDs
+enum ParamIDs : ParamID {
+    kParamTone = 1000,
+    kParamAttack,
+    kParamDecay,
+    kParamSustain,
+    kParamRelease,
+    kParamGain,
+    kParamPolyphony,
+    kParamTableSize,
+    kParamQuantize4,
+    kParamDetune,           // fine detune +/- 0.5 semitone
+    kParamVibratoDepth,     // vibrato depth 0..0.5 st
+    kParamVibratoRate,      // vibrato rate 0..16 Hz
+    kParamNoiseAdd,         // additive noise depth 0..100 (relative to |signal|)
+    kParamBLQuality,        // bandlimit quality 0=Off, 1..8 bands per octave
+    kParamHQMode,           // 0=Off,1=Auto2x,2=Force2x,3=Force4x,4=Force8x
+    kParamPreHighCutMode,   // 0=Off,1=Fixed,2=ByMaxNote
+    kParamPreHighCutMaxNote,// 0..127
+    kParamHQPath,           // 0=PerVoice,1=Bus
+};
+
+// Component state: version, count, then the normalized value of every parameter from
+// kParamTone on (< 0: never set, the default applies).
+// Version 1 stored Polyphony on the old 1..32 scale; version 2 uses 1..128.
+constexpr int32 kStateVersion = 2;
+constexpr int32 kNumStateParams = kParamHQPath - kParamTone + 1;
+using StateValues = std::array<ParamValue, kNumStateParams>;
+
+// Reads any version up to kStateVersion (values of newer parameters are skipped) and
+// migrates it to the current layout
+inline bool readState(Steinberg::IBStream* state, StateValues& values) {
+    Steinberg::IBStreamer s(state, Steinberg::kLittleEndian);
+    int32 version = 0, count = 0;
+    if (!s.readInt32(version) || !s.readInt32(count) || version < 1 || count < 0) return false;
+    values.fill(-1.0);
+    for (int32 k = 0; k < count; ++k) {
+        double v;
+        if (!s.readDouble(v)) return false;
+        if (k < kNumStateParams) values[(size_t)k] = (v < 0.0) ? -1.0 : std::min(v, 1.0);
+    }
+    ParamValue& poly = values[kParamPolyphony - kParamTone];
+    if (version < 2 && poly >= 0.0) {
+        int n = 1 + (int)std::floor(poly * 31.0 + 0.5);
+        n = std::max(1, std::min(32, n));
+        poly = (n - 1) / 127.0; // same voice count on the 1..128 scale
+    }
+    return true;
+}
+
+inline bool writeState(Steinberg::IBStream* state, const StateValues& values) {
+    Steinberg::IBStreamer s(state, Steinberg::kLittleEndian);
+    if (!s.writeInt32(kStateVersion) || !s.writeInt32(kNumStateParams)) return false;
+    for (ParamValue v : values) {
+        if (!s.writeDouble(v)) return false;
+    }
+    return true;
+}
+
+// Latest-value mailbox (triple buffer, as in TableBuilder) for one writer thread and one
+// reader thread; neither side blocks or allocates.
+class StateMailbox {
+public:
+    StateMailbox() { for (auto& s : slots_) s.fill(-1.0); }
+    // Writer: publish values (replaces any the reader has not taken yet)
+    void write(const StateValues& v) {
+        slots_[(size_t)writeIdx_] = v;
+        writeIdx_ = shared_.exchange(writeIdx_ | kDirty, std::memory_order_acq_rel) & 3;
+    }
+    // Reader: switch to the newest values; false if nothing was written since the last take
+    bool take() {
+        if (!(shared_.load(std::memory_order_acquire) & kDirty)) return false;
+        readIdx_ = shared_.exchange(readIdx_, std::memory_order_acq_rel) & 3;
+        return true;
+    }
+    // Reader: the values of the last take() (all < 0 before the first write)
+    const StateValues& latest() const { return slots_[(size_t)readIdx_]; }
+private:
+    static constexpr int kDirty = 4;
+    std::array<StateValues, 3> slots_;
+    std::atomic<int> shared_{2};
+    int writeIdx_ = 0;
+    int readIdx_ = 1;
+};
+
+}
+}
+#endif // HAVE_VST3_SDK